@@ -5,6 +5,23 @@ pub fn build(b: *Build) void {
     const target = b.standardTargetOptions(.{});
     const optimize = b.standardOptimizeOption(.{});
 
+    // The simulation core, with no SDL, for the game and headless tools alike
+    const core = b.addStaticLibrary(.{
+        .name = "vectoroids_core",
+        .optimize = optimize,
+        .target = target,
+    });
+    core.addCSourceFiles(&.{
+        "vectoroids_core.c",
+    }, &.{
+        "-std=c2x",
+    });
+
+    core.linkSystemLibrary("c");
+    core.installHeader("vectoroids_core.h", "vectoroids_core.h");
+
+    b.installArtifact(core);
+
     const exe = b.addExecutable(.{
         .name = "vectoroids",
         .optimize = optimize,
@@ -16,6 +33,7 @@ pub fn build(b: *Build) void {
         "-std=c2x",
     });
 
+    exe.linkLibrary(core);
     exe.linkSystemLibrary("c");
     exe.linkSystemLibrary("sdl2");
     exe.linkSystemLibrary("SDL2_image");
@@ -27,6 +45,9 @@ pub fn build(b: *Build) void {
 
     b.installArtifact(exe);
 
+    const core_step = b.step("core", "Build just the core library");
+    core_step.dependOn(&b.addInstallArtifact(core, .{}).step);
+
     const play = b.step("play", "Play the game");
     const run = b.addRunArtifact(exe);
     run.step.dependOn(b.getInstallStep());
@@ -22,42 +22,51 @@
 
 #define kGameName "Vectoroids"
 #define kGameVersion "1.2.0"
-#define kGameDate "2023.08.17"
+#define kGameDate "2026.10.18"
+
+#ifdef LINUX
+#define _GNU_SOURCE
+#endif
 
 #include <assert.h>
+#include <errno.h>
 #include <math.h>
 #include <stdbool.h>
+#include <stddef.h>
 #include <stdint.h>
 #include <stdio.h>
 #include <stdlib.h>
 #include <string.h>
 
+#ifdef LINUX
+#include <sched.h>
+#include <sys/mman.h>
+#endif
+
 #include <SDL.h>
 #include <SDL_image.h>
 #include <SDL_mixer.h>
 
+#include "vectoroids_core_internal.h"
+
 #ifndef DATA_PREFIX
 #define DATA_PREFIX "data/"
 #endif
 
-/* Constraints: */
-
-#define kNumBullets 2
-
-#define kNumAsteroids 20
-#define kNumBits 50
-
-#define kAsteroidsSides 6
-#define kAsteroidsRadius 10
-#define kShipRadius 20
+/* Constraints (the simulation's own are in vectoroids_core.h and
+   vectoroids_core_internal.h): */
 
-#define kZoomStart 40
-#define kOneUpScore 10000
+#define kParticleBatch 4096
+#define kJobQueue 256
+#define kJobSpins 256
 #define kScreenFPS 60
-#define kFrameDelay (1000 / kScreenFPS)
-
-#define kScreenWidth 480
-#define kScreenHeight 480
+#define kFrameSpinUs 2000
+#define kMaxSimSteps 8
+#define kAttractFPS 20
+#define kIdleFPS 4
+#define kPauseWaitMs 1000
+#define kLerpFar 32
+#define kHeadlessFrames 100000
 
 #define LEFT_EDGE 0x0001
 #define RIGHT_EDGE 0x0002
@@ -73,63 +82,101 @@ struct Letter
   int32_t xm, ym;
 };
 
-typedef struct Bullet Bullet;
-struct Bullet
+typedef struct Segment Segment;
+struct Segment
 {
-  int32_t timer;
-  int32_t x;
-  int32_t y;
-  int32_t xm;
-  int32_t ym;
+  int32_t x1;
+  int32_t y1;
+  int32_t x2;
+  int32_t y2;
+  int32_t edge;
 };
 
-typedef struct Shape Shape;
-struct Shape
-{
-  int32_t radius;
-  int32_t angle;
-};
+/* Transformed and clipped outline of an asteroid, reused until the rock
+   moves or one of its (quantized) vertex angles changes: */
 
-typedef struct Asteroid Asteroid;
-struct Asteroid
+typedef struct AsteroidCache AsteroidCache;
+struct AsteroidCache
 {
-  int32_t alive;
-  int32_t size;
+  bool valid;
   int32_t x;
   int32_t y;
-  int32_t xm;
-  int32_t ym;
-  int32_t angle;
-  int32_t angle_m;
+  int32_t size;
+  int32_t angle[kAsteroidsSides];
   Shape shape[kAsteroidsSides];
+  size_t num_segments;
+  Segment segments[kAsteroidsSides * 3];
+};
+
+/* Frame pacing: */
+
+enum
+{
+  SYNC_VSYNC,
+  SYNC_LIMIT,
+  SYNC_OFF
 };
 
-typedef struct Bit Bit;
-struct Bit
+/* Everything the renderer needs from one simulation step: */
+
+typedef struct Snapshot Snapshot;
+struct Snapshot
 {
-  int32_t timer;
-  int32_t x;
-  int32_t y;
-  int32_t xm;
-  int32_t ym;
+  int32_t player_x;
+  int32_t player_y;
+  int32_t player_angle;
+  int32_t player_alive;
+  int32_t player_die_timer;
+  bool thrust;
+  size_t num_bullets;
+  size_t bullets_used;
+  size_t num_asteroids;
+  size_t asteroids_used;
+  size_t lives;
+  size_t score;
+  size_t level;
+  int32_t text_zoom;
+  char zoom_str[24];
+  Uint64 time;
+  Uint32 stamp;
+
+  /* Each snapshot's own tables, of which only the slots in use are
+     copied; keep these last: */
+
+  Bullets bullets;
+  int32_t* bullets_live;
+  Asteroids asteroids;
+  int32_t* asteroids_live;
+  Shape (*shapes)[kAsteroidsSides];
+  Particles particles;
+  int32_t* grid_head;
+  int32_t* grid_next;
 };
 
-/* Data: */
+/* Latency histogram, in 1 ms bins (the last bin collects the rest): */
 
-enum
+#define kLatencyBins 64
+
+typedef struct Histogram Histogram;
+struct Histogram
 {
-  SND_BULLET,
-  SND_AST1,
-  SND_AST2,
-  SND_AST3,
-  SND_AST4,
-  SND_THRUST,
-  SND_EXPLODE,
-  SND_GAMEOVER,
-  SND_EXTRALIFE,
-  NUM_SOUNDS
+  size_t count[kLatencyBins];
+  size_t total;
+  Uint64 sum;
+  Uint32 max;
 };
 
+/* Bits of the held-controls mask shared with the simulation thread: */
+
+#define INPUT_LEFT 0x0001
+#define INPUT_RIGHT 0x0002
+#define INPUT_UP 0x0004
+#define INPUT_SHIFT 0x0008
+
+#define kSnapFresh 0x0100
+
+/* Data: */
+
 const char* sound_names[NUM_SOUNDS] = {
   DATA_PREFIX "sounds/bullet.wav",
   DATA_PREFIX "sounds/ast1.wav",
@@ -157,24 +204,99 @@ const char* mus_game_name = DATA_PREFIX "music/decision.s3m";
 SDL_Window* g_window = 0;
 SDL_Renderer* g_renderer = 0;
 SDL_Texture* g_texture = 0;
+SDL_Texture* g_screen = 0;
+uint16_t* g_pixels = 0;
+uint16_t* g_background = 0;
 Uint64 g_frame_start = 0;
 Uint64 g_frame_time = 0;
+Uint64 g_frame_period = 0;
+Uint64 g_frame_deadline = 0;
+Uint64 g_frame_last = 0;
+size_t frames_timed = 0, frames_missed = 0;
+bool use_realtime = false;
+int32_t realtime_cpu = -1;
+int32_t sync_mode = SYNC_VSYNC;
+Uint64 g_sim_period = 0;
+Uint64 g_sim_acc = 0;
+Uint64 g_sim_last = 0;
+Snapshot snapshots[2] = {0};
+
+/* Simulation thread, and the triple buffer it publishes snapshots into: */
+
+SDL_Thread* sim_thread = 0;
+SDL_atomic_t sim_stop = {0};
+SDL_atomic_t sim_over = {0};
+SDL_atomic_t input_held = {0};
+SDL_atomic_t input_fire = {0};
+SDL_atomic_t input_stamp = {0};
+Snapshot snap_buffers[3] = {0};
+SDL_atomic_t snap_middle = {2};
+int32_t snap_back = 1;
+int32_t snap_front = 0;
+Uint32 snap_carry = 0;
 Mix_Chunk* sounds[NUM_SOUNDS] = {0};
 Mix_Music* game_music = 0;
 #ifdef JOY_YES
 SDL_Joystick* js = 0;
 #endif
-Bullet bullets[kNumBullets] = {0};
-Asteroid asteroids[kNumAsteroids] = {0};
-Bit bits[kNumBits] = {0};
-bool use_sound = true, use_joystick = false, fullscreen = false;
-int32_t text_zoom = 0;
-char zoom_str[24] = {0};
-int32_t player_x = 0, player_y = 0, player_xm = 0, player_ym = 0, player_angle = 0;
-int32_t player_alive = 0, player_die_timer = 0;
-size_t lives = 0, score = 0, high = 0, level = 0;
+AsteroidCache* asteroid_cache = 0;
+
+/* The view is a screen-sized window onto the (wrapping) world.  View
+   coordinates are wrapped into [view_lo, view_lo + world size), which
+   centers the view in the world (and, with a one-screen world, is just
+   the screen): */
+
+int32_t view_lo_x = 0;
+int32_t view_lo_y = 0;
+
+/* Work-stealing job system: every worker owns a deque of chunk jobs, takes
+   its own from the bottom and steals from the top of the others'.  Worker
+   0 is the thread handing the jobs out, which is always the simulation: */
+
+typedef struct Job Job;
+struct Job
+{
+  JobFn fn;
+  void* data;
+  size_t begin;
+  size_t end;
+};
+
+typedef struct Deque Deque;
+struct Deque
+{
+  SDL_SpinLock lock;
+  size_t top;
+  size_t bottom;
+  Job jobs[kJobQueue];
+};
+
+Deque job_deques[kMaxWorkers] = {0};
+SDL_Thread* job_threads[kMaxWorkers] = {0};
+size_t num_workers = 1;
+SDL_sem* jobs_wake = 0;
+SDL_sem* jobs_done = 0;
+SDL_atomic_t jobs_pending = {0};
+SDL_atomic_t jobs_stop = {0};
+
+/* Points of particle streaks waiting to be drawn, and their shadows: */
+
+SDL_Point particle_points[2][kParticleBatch] = {0};
+size_t particle_batch = 0;
+bool use_sound = true, use_joystick = false, fullscreen = false, use_rgb565 = false, use_threads = false;
+bool show_latency = false, late_input = false;
+Histogram latency_sim = {0}, latency_present = {0};
+Uint32 present_stamp = 0;
+size_t high = 0;
 bool game_pending = false;
 
+/* Headless runs step the simulation flat out, with no window or sound: */
+
+bool headless = false;
+size_t headless_frames = kHeadlessFrames;
+bool use_seed = false;
+uint64_t game_seed = 0;
+
 /* Trig junk:  (thanks to Atari BASIC for this) */
 
 int32_t trig[12] = {
@@ -452,59 +574,76 @@ int32_t char_vectors[36][5][4] = {
 
 bool title(void);
 bool game(void);
+void headless_run(void);
+void game_draw(const Snapshot* prev, const Snapshot* cur, int32_t alpha);
+void snapshot_copy(Snapshot* dst, const Snapshot* src);
+void bullets_copy(Bullets* dst, const Bullets* src, size_t n);
+void asteroids_copy(Asteroids* dst, const Asteroids* src, size_t n);
+void view_alloc(void);
+void snapshot_alloc(Snapshot* snap);
+void snapshot_take(Snapshot* snap, const Input* input);
+int32_t lerp_wrap(int32_t from, int32_t to, int32_t alpha, int32_t size, int32_t far);
+void sim_clock_reset(void);
+size_t sim_steps_due(void);
+int32_t sim_alpha(void);
+int sim_run(void* data);
+void sim_start(void);
+void sim_end(void);
+void jobs_start(size_t count);
+void jobs_end(void);
+void jobs_parallel(JobFn fn, void* data, size_t n, size_t size);
+int jobs_worker(void* data);
+bool job_take(size_t self, Job* job);
+void game_pause(const Snapshot* snap, bool* done, bool* quit);
+void idle_wait(Uint32 fps);
+void game_events(Input* input, bool* done, bool* quit, bool* pause);
+Uint32 input_consume(Input* input);
+void histogram_add(Histogram* h, Uint32 ms);
+void histogram_print(FILE* f, const char* name, const Histogram* h);
+void snapshot_publish(void);
+bool snapshot_acquire(void);
 void finish(void);
+int32_t view_wrap(int32_t v, int32_t lo, int32_t size);
 void setup(const int argc, const char* argv[]);
 int32_t fast_cos(int32_t v);
 int32_t fast_sin(int32_t v);
+double trig_exact(double turns);
+double trig_error(double a, double b);
+void trig_bench(void);
 void draw_line(int32_t x1, int32_t y1, SDL_Color c1, int32_t x2, int32_t y2, SDL_Color c2);
+size_t wrap_line(int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t lines[3][4]);
 int32_t clip(int32_t* x1, int32_t* y1, int32_t* x2, int32_t* y2);
 SDL_Color mkcolor(int32_t r, int32_t g, int32_t b);
 void sdl_drawline(int32_t x1, int32_t y1, SDL_Color c1, int32_t x2, int32_t y2, SDL_Color c2);
+void raster_line(int32_t x1, int32_t y1, SDL_Color c1, int32_t x2, int32_t y2, SDL_Color c2);
 uint8_t encode(double x, double y);
 void drawvertline(int32_t x, int32_t y1, SDL_Color c1, int32_t y2, SDL_Color c2);
 void putpixel(int32_t x, int32_t y, SDL_Color color);
+void screen_clear(bool background);
+void screen_present(void);
+void frame_sync(void);
+void frame_sync_reset(void);
+void realtime_setup(void);
+void realtime_thread(int32_t cpu, const char* name);
+void prefault(void* p, size_t size);
+void load_background(void);
 void draw_segment(int32_t r1, int32_t a1, SDL_Color c1, int32_t r2, int32_t a2, SDL_Color c2, int32_t cx, int32_t cy, int32_t ang);
-void add_bullet(int32_t x, int32_t y, int32_t a, int32_t xm, int32_t ym);
-void add_asteroid(int32_t x, int32_t y, int32_t xm, int32_t ym, int32_t size);
-void add_bit(int32_t x, int32_t y, int32_t xm, int32_t ym);
-void draw_asteroid(int32_t size, int32_t x, int32_t y, int32_t angle, Shape* shape);
+void particles_copy(Particles* dst, const Particles* src);
+void particles_draw(const Particles* p, int32_t alpha, int32_t cam_x, int32_t cam_y);
+void particles_plot(int32_t x, int32_t y);
+void particles_flush(void);
+void draw_asteroid(int32_t size, int32_t x, int32_t y, int32_t angle, const Shape* shape, AsteroidCache* cache);
 void playsound(int32_t snd);
-void hurt_asteroid(int32_t j, int32_t xm, int32_t ym, size_t exp_size);
-void add_score(int32_t amount);
+void sounds_play(const Input* input);
+void rocks_bench(void);
 void draw_char(char c, int32_t x, int32_t y, int32_t r, SDL_Color cl);
 void draw_text(char* str, int32_t x, int32_t y, int32_t s, SDL_Color c);
 void draw_thick_line(int32_t x1, int32_t y1, SDL_Color c1, int32_t x2, int32_t y2, SDL_Color c2);
-void reset_level(void);
 void show_version(void);
 void show_usage(FILE* f, const char* prg);
 void draw_centered_text(char* str, int32_t y, int32_t s, SDL_Color c);
 const char* user_file_path_get(const char* file_name);
 
-/* PRNG - xoshiro256++ */
-
-uint64_t rngstate[4] = {0xdeadbeef, 0x8badf00d, 0xbaaaaaad, 0xfeedc0de};
-
-static inline uint64_t
-rotl(const uint64_t x, int k)
-{
-  return (x << k) | (x >> (64 - k));
-}
-
-// Returns a Uint64 random number
-uint64_t
-random_get(void)
-{
-  const uint64_t result = rotl(rngstate[0] + rngstate[3], 23) + rngstate[0];
-  const uint64_t t = rngstate[1] << 17;
-  rngstate[2] ^= rngstate[0];
-  rngstate[3] ^= rngstate[1];
-  rngstate[1] ^= rngstate[2];
-  rngstate[0] ^= rngstate[3];
-  rngstate[2] ^= t;
-  rngstate[3] = rotl(rngstate[3], 45);
-  return result;
-}
-
 /* File manipulation */
 
 const char*
@@ -574,9 +713,28 @@ main(const int argc, const char* argv[])
       fread(&player_xm, sizeof(int), 1, fi);
       fread(&player_ym, sizeof(int), 1, fi);
       fread(&player_angle, sizeof(int), 1, fi);
-      fread(bullets, sizeof(Bullet), kNumBullets, fi);
-      fread(asteroids, sizeof(Asteroid), kNumAsteroids, fi);
-      fread(bits, sizeof(Bit), kNumBits, fi);
+
+      /* The tables can only be restored into ones of the same size: */
+
+      size_t saved_bullets = 0, saved_asteroids = 0;
+      int32_t saved_w = 0, saved_h = 0;
+
+      fread(&saved_bullets, sizeof(size_t), 1, fi);
+      fread(&saved_asteroids, sizeof(size_t), 1, fi);
+      fread(&saved_w, sizeof(int32_t), 1, fi);
+      fread(&saved_h, sizeof(int32_t), 1, fi);
+
+      if (saved_bullets == max_bullets && saved_asteroids == max_asteroids && saved_w == world_w && saved_h == world_h)
+      {
+        state_tables(fi, false);
+      }
+      else if (game_pending)
+      {
+        fprintf(stderr,
+                "\nWarning: The saved game was played with different "
+                "capacities or world size,\nso it cannot be resumed.\n\n");
+        game_pending = false;
+      }
     }
 
     if (fclose(fi))
@@ -623,9 +781,11 @@ main(const int argc, const char* argv[])
     fwrite(&player_xm, sizeof(int), 1, fi);
     fwrite(&player_ym, sizeof(int), 1, fi);
     fwrite(&player_angle, sizeof(int), 1, fi);
-    fwrite(bullets, sizeof(Bullet), kNumBullets, fi);
-    fwrite(asteroids, sizeof(Asteroid), kNumAsteroids, fi);
-    fwrite(bits, sizeof(Bit), kNumBits, fi);
+    fwrite(&max_bullets, sizeof(size_t), 1, fi);
+    fwrite(&max_asteroids, sizeof(size_t), 1, fi);
+    fwrite(&world_w, sizeof(int32_t), 1, fi);
+    fwrite(&world_h, sizeof(int32_t), 1, fi);
+    state_tables(fi, true);
 
     if (fclose(fi))
     {
@@ -652,16 +812,16 @@ title(void)
   Letter letters[11] = {0};
   for (size_t i = 0; i < strlen(titlestr); i++)
   {
-    letters[i].x = (random_get() % kScreenWidth);
-    letters[i].y = (random_get() % kScreenHeight);
+    letters[i].x = random_effect(screen_w);
+    letters[i].y = random_effect(screen_h);
     letters[i].xm = 0;
     letters[i].ym = 0;
   }
 
-  int32_t x = (random_get() % kScreenWidth);
-  int32_t y = (random_get() % kScreenHeight);
-  int32_t xm = (random_get() % 4) + 2;
-  int32_t ym = (random_get() % 10) - 5;
+  int32_t x = random_effect(screen_w);
+  int32_t y = random_effect(screen_h);
+  int32_t xm = random_effect(4) + 2;
+  int32_t ym = random_effect(10) - 5;
 
   int32_t size = 40;
 
@@ -669,43 +829,14 @@ title(void)
 
   bool done = false;
   int32_t angle = 0;
-  for (size_t counter = 0; !done; ++counter)
-  {
-    g_frame_start = SDL_GetTicks64();
-
-    /* Rotate rock: */
-
-    angle = ((angle + 2) % 360);
-
-    /* Make rock grow: */
-
-    if (!(counter % 3))
-    {
-      if (size > 1)
-      {
-        --size;
-      }
-    }
-
-    /* Move rock: */
-
-    x += xm;
-
-    if (x >= kScreenWidth)
-    {
-      x -= kScreenWidth;
-    }
+  size_t counter = 0;
 
-    y += ym;
+  sim_clock_reset();
+  frame_sync_reset();
 
-    if (y >= kScreenHeight)
-    {
-      y -= kScreenHeight;
-    }
-    else if (y < 0)
-    {
-      y += kScreenHeight;
-    }
+  while (!done)
+  {
+    g_frame_start = SDL_GetPerformanceCounter();
 
     /* Handle events: */
 
@@ -740,78 +871,118 @@ title(void)
 #endif
       else if (event.type == SDL_MOUSEBUTTONDOWN)
       {
-        if (event.button.x >= (kScreenWidth - 50) / 2 && event.button.x <= (kScreenWidth + 50) / 2 && event.button.y >= 180 && event.button.y <= 195)
+        if (event.button.x >= (screen_w - 50) / 2 && event.button.x <= (screen_w + 50) / 2 && event.button.y >= 180 && event.button.y <= 195)
         {
           /* Start! */
 
           game_pending = false;
           done = true;
         }
-        else if (event.button.x >= (kScreenWidth - 80) / 2 && event.button.x <= (kScreenWidth + 80) / 2 && event.button.y >= 200 && event.button.y <= 215 && game_pending)
+        else if (event.button.x >= (screen_w - 80) / 2 && event.button.x <= (screen_w + 80) / 2 && event.button.y >= 200 && event.button.y <= 215 && game_pending)
         {
           done = true;
         }
       }
     }
 
-    /* Move title characters: */
+    /* Animate at the fixed step rate: */
 
-    if (snapped < strlen(titlestr))
+    for (size_t n = sim_steps_due(); n > 0; --n, ++counter)
     {
-      for (size_t i = 0; i < strlen(titlestr); ++i)
-      {
-        letters[i].x = letters[i].x + letters[i].xm;
-        letters[i].y = letters[i].y + letters[i].ym;
+      /* Rotate rock: */
 
-        /* Home in on final spot! */
+      angle = ((angle + 2) % 360);
 
-        if (letters[i].x > ((kScreenWidth - (strlen(titlestr) * 14)) / 2 + (i * 14)) && letters[i].xm > -4)
-        {
-          letters[i].xm--;
-        }
-        else if (letters[i].x < ((kScreenWidth - (strlen(titlestr) * 14)) / 2 + (i * 14)) && letters[i].xm < 4)
-        {
-          letters[i].xm++;
-        }
+      /* Make rock grow: */
 
-        if (letters[i].y > 100 && letters[i].ym > -4)
-        {
-          letters[i].ym--;
-        }
-        else if (letters[i].y < 100 && letters[i].ym < 4)
+      if (!(counter % 3))
+      {
+        if (size > 1)
         {
-          letters[i].ym++;
+          --size;
         }
+      }
+
+      /* Move rock: */
+
+      x += xm;
+
+      if (x >= screen_w)
+      {
+        x -= screen_w;
+      }
+
+      y += ym;
 
-        /* Snap into place: */
+      if (y >= screen_h)
+      {
+        y -= screen_h;
+      }
+      else if (y < 0)
+      {
+        y += screen_h;
+      }
 
-        if (letters[i].x >= ((kScreenWidth - (strlen(titlestr) * 14)) / 2 + (i * 14)) - 8 && letters[i].x <= ((kScreenWidth - (strlen(titlestr) * 14)) / 2 + (i * 14)) + 8 && letters[i].y >= 92 && letters[i].y <= 108 && (letters[i].xm != 0 || letters[i].ym != 0))
+      /* Move title characters: */
+
+      if (snapped < strlen(titlestr))
+      {
+        for (size_t i = 0; i < strlen(titlestr); ++i)
         {
-          letters[i].x = ((kScreenWidth - (strlen(titlestr) * 14)) / 2 + (i * 14));
-          letters[i].xm = 0;
+          letters[i].x = letters[i].x + letters[i].xm;
+          letters[i].y = letters[i].y + letters[i].ym;
+
+          /* Home in on final spot! */
+
+          if (letters[i].x > ((screen_w - (strlen(titlestr) * 14)) / 2 + (i * 14)) && letters[i].xm > -4)
+          {
+            letters[i].xm--;
+          }
+          else if (letters[i].x < ((screen_w - (strlen(titlestr) * 14)) / 2 + (i * 14)) && letters[i].xm < 4)
+          {
+            letters[i].xm++;
+          }
+
+          if (letters[i].y > 100 && letters[i].ym > -4)
+          {
+            letters[i].ym--;
+          }
+          else if (letters[i].y < 100 && letters[i].ym < 4)
+          {
+            letters[i].ym++;
+          }
+
+          /* Snap into place: */
+
+          if (letters[i].x >= ((screen_w - (strlen(titlestr) * 14)) / 2 + (i * 14)) - 8 && letters[i].x <= ((screen_w - (strlen(titlestr) * 14)) / 2 + (i * 14)) + 8 && letters[i].y >= 92 && letters[i].y <= 108 && (letters[i].xm != 0 || letters[i].ym != 0))
+          {
+            letters[i].x = ((screen_w - (strlen(titlestr) * 14)) / 2 + (i * 14));
+            letters[i].xm = 0;
 
-          letters[i].y = 100;
-          letters[i].ym = 0;
+            letters[i].y = 100;
+            letters[i].ym = 0;
 
-          ++snapped;
+            ++snapped;
+          }
         }
       }
     }
 
+    /* Minimized?  Draw nothing, and just wait for something to happen: */
+
+    if (SDL_GetWindowFlags(g_window) & SDL_WINDOW_MINIMIZED)
+    {
+      SDL_WaitEventTimeout(NULL, kPauseWaitMs);
+      sim_clock_reset();
+      frame_sync_reset();
+      continue;
+    }
+
     /* Draw screen: */
 
     /* (Erase first) */
 
-    if (SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, 255))
-    {
-      fprintf(stderr, "SDL_SetRenderDrawControl: %s\n", SDL_GetError());
-      exit(EXIT_FAILURE);
-    }
-    if (SDL_RenderClear(g_renderer))
-    {
-      fprintf(stderr, "SDL_RenderClear: %s\n", SDL_GetError());
-      exit(EXIT_FAILURE);
-    }
+    screen_clear(false);
 
     /* (Title) */
 
@@ -844,8 +1015,8 @@ title(void)
       char str[20] = {0};
 
       sprintf(str, "HIGH %.6ld", high);
-      draw_text(str, (kScreenWidth - 110) / 2, 5, 5, mkcolor(128, 255, 255));
-      draw_text(str, (kScreenWidth - 110) / 2 + 1, 6, 5, mkcolor(128, 255, 255));
+      draw_text(str, (screen_w - 110) / 2, 5, 5, mkcolor(128, 255, 255));
+      draw_text(str, (screen_w - 110) / 2 + 1, 6, 5, mkcolor(128, 255, 255));
 
       if (score && (score != high || (counter % 20) < 10))
       {
@@ -857,16 +1028,16 @@ title(void)
         {
           sprintf(str, "SCR  %.6ld", score);
         }
-        draw_text(str, (kScreenWidth - 110) / 2, 25, 5, mkcolor(128, 128, 255));
-        draw_text(str, (kScreenWidth - 110) / 2 + 1, 26, 5, mkcolor(128, 128, 255));
+        draw_text(str, (screen_w - 110) / 2, 25, 5, mkcolor(128, 128, 255));
+        draw_text(str, (screen_w - 110) / 2 + 1, 26, 5, mkcolor(128, 128, 255));
       }
     }
 
-    draw_text("START", (kScreenWidth - 50) / 2, 180, 5, mkcolor(0, 255, 0));
+    draw_text("START", (screen_w - 50) / 2, 180, 5, mkcolor(0, 255, 0));
 
     if (game_pending)
     {
-      draw_text("CONTINUE", (kScreenWidth - 80) / 2, 200, 5, mkcolor(0, 255, 0));
+      draw_text("CONTINUE", (screen_w - 80) / 2, 200, 5, mkcolor(0, 255, 0));
     }
 
     /* (Giant rock) */
@@ -884,15 +1055,24 @@ title(void)
     draw_segment(30 / size, 300, mkcolor(255, 255, 255), 45 / size, 335, mkcolor(255, 255, 255), x, y, angle);
     draw_segment(45 / size, 335, mkcolor(255, 255, 255), 40 / size, 0, mkcolor(255, 255, 255), x, y, angle);
 
-    /* Flush and pause! */
-    g_frame_time = SDL_GetTicks64() - g_frame_start;
+    /* Flush and pause!  (Once the title has settled, or if nobody is
+       looking, at a much lower rate.) */
 
-    if (kFrameDelay > g_frame_time)
+    screen_present();
+    g_frame_time = SDL_GetPerformanceCounter() - g_frame_start;
+
+    if (!(SDL_GetWindowFlags(g_window) & SDL_WINDOW_INPUT_FOCUS))
     {
-      SDL_Delay(kFrameDelay - g_frame_time);
+      idle_wait(kIdleFPS);
+    }
+    else if (snapped == strlen(titlestr))
+    {
+      idle_wait(kAttractFPS);
+    }
+    else
+    {
+      frame_sync();
     }
-
-    SDL_RenderPresent(g_renderer);
   }
 
   return quit;
@@ -905,23 +1085,18 @@ game(void)
 {
   if (!game_pending)
   {
-    lives = 3;
-    score = 0;
-
-    player_alive = 1;
-    player_die_timer = 0;
-    player_angle = 90;
-    player_x = (kScreenWidth / 2) << 4;
-    player_y = (kScreenHeight / 2) << 4;
-    player_xm = 0;
-    player_ym = 0;
-
-    level = 1;
-    reset_level();
+    game_reset();
   }
 
   game_pending = true;
 
+  /* (The bullets and asteroids may have come from the state file:) */
+
+  pool_rebuild(&bullet_pool, bullets.timer);
+  pool_rebuild(&asteroid_pool, asteroids.alive);
+
+  grid_rebuild();
+
   /* Hide mouse cursor: */
 
   if (fullscreen)
@@ -939,716 +1114,1414 @@ game(void)
     }
   }
 
-  size_t counter = 0;
   bool quit = false;
   bool done = false;
 
-  bool left_pressed = false;
-  bool right_pressed = false;
-  bool up_pressed = false;
-  bool shift_pressed = false;
+  Input input = {0};
+
+  sim_counter = 0;
+  snapshot_take(&snapshots[0], &input);
+  snapshot_copy(&snapshots[1], &snapshots[0]);
+  sim_clock_reset();
+  frame_sync_reset();
+
+  sim_start();
+
+  bool pause = false;
+
   while (!done)
   {
-    g_frame_start = SDL_GetTicks64();
-    ++counter;
+    g_frame_start = SDL_GetPerformanceCounter();
 
     /* Handle events: */
 
-    SDL_Event event = {0};
-    while (SDL_PollEvent(&event) > 0)
+    game_events(&input, &done, &quit, &pause);
+
+    if (pause && !done)
     {
-      if (event.type == SDL_QUIT)
-      {
-        /* Quit! */
+      pause = false;
+      sim_end();
 
-        done = true;
-        quit = true;
-      }
-      else if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP)
+      if (use_threads && SDL_AtomicGet(&sim_over))
       {
-        if (event.type == SDL_KEYDOWN)
-        {
-          switch (event.key.keysym.scancode)
-          {
-            case SDL_SCANCODE_ESCAPE:
-              /* Return to menu! */
-              done = true;
-              break;
-
-              /* Key press... */
-            case SDL_SCANCODE_RIGHT:
-              /* Rotate CW */
-              left_pressed = false;
-              right_pressed = true;
-              break;
-            case SDL_SCANCODE_LEFT:
-              /* Rotate CCW */
-              left_pressed = true;
-              right_pressed = false;
-              break;
-            case SDL_SCANCODE_UP:
-              /* Thrust! */
-              up_pressed = true;
-              break;
-            case SDL_SCANCODE_SPACE:
-              if (player_alive)
-              {
-                /* Fire a bullet! */
-                add_bullet(player_x >> 4, player_y >> 4, player_angle, player_xm, player_ym);
-              }
-              break;
-            case SDL_SCANCODE_LSHIFT:
-            case SDL_SCANCODE_RSHIFT:
-              /* Respawn now (if applicable) */
-              shift_pressed = true;
-              break;
-            default:
-              break;
-          }
-        }
-        else if (event.type == SDL_KEYUP)
-        {
-          /* Key release... */
-          switch (event.key.keysym.scancode)
-          {
-            case SDL_SCANCODE_RIGHT:
-              right_pressed = false;
-              break;
-            case SDL_SCANCODE_LEFT:
-              left_pressed = false;
-              break;
-            case SDL_SCANCODE_UP:
-              up_pressed = false;
-              break;
-            case SDL_SCANCODE_LSHIFT:
-            case SDL_SCANCODE_RSHIFT:
-              /* Respawn now (if applicable) */
-              shift_pressed = false;
-              break;
-            default:
-              break;
-          }
-        }
+        done = true;
+        game_pending = false;
+        continue;
       }
-#ifdef JOY_YES
-      else if (event.type == SDL_JOYBUTTONDOWN && player_alive)
-      {
-        if (event.jbutton.button == JOY_B)
-        {
-          /* Fire a bullet! */
 
-          add_bullet(x >> 4, y >> 4, angle, player_xm, player_ym);
-        }
-        else if (event.jbutton.button == JOY_A)
-        {
-          /* Thrust: */
+      snapshot_take(&snapshots[1], &(Input){0});
+      snapshot_copy(&snapshots[0], &snapshots[1]);
 
-          up_pressed = true;
-        }
-        else
-        {
-          shift_pressed = true;
-        }
-      }
-      else if (event.type == SDL_JOYBUTTONUP)
-      {
-        if (event.jbutton.button == JOY_A)
-        {
-          /* Stop thrust: */
+      game_pause(&snapshots[1], &done, &quit);
 
-          up_pressed = false;
-        }
-        else if (event.jbutton.button != JOY_B)
-        {
-          shift_pressed = false;
-        }
-      }
-      else if (event.type == SDL_JOYAXISMOTION)
-      {
-        if (event.jaxis.axis == JOY_X)
-        {
-          if (event.jaxis.value < -256)
-          {
-            left_pressed = true;
-            right_pressed = false;
-          }
-          else if (event.jaxis.value > 256)
-          {
-            left_pressed = false;
-            right_pressed = true;
-          }
-          else
-          {
-            left_pressed = false;
-            right_pressed = false;
-          }
-        }
-      }
-#endif
-    }
+      /* Keys may have been released while we were away: */
 
-    /* Rotate ship: */
+      input = (Input){0};
+      sim_clock_reset();
+      frame_sync_reset();
 
-    if (right_pressed)
-    {
-      player_angle -= 8;
-      if (player_angle < 0)
-      {
-        player_angle += 360;
-      }
-    }
-    else if (left_pressed)
-    {
-      player_angle += 8;
-      if (player_angle >= 360)
+      if (!done)
       {
-        player_angle -= 360;
+        sim_start();
       }
+      continue;
     }
 
-    /* Thrust ship: */
+    int32_t alpha = 0;
 
-    if (up_pressed && player_alive)
+    if (use_threads)
     {
-      /* Move forward: */
+      /* Pass controls to the simulation thread: */
 
-      player_xm += (fast_cos(player_angle >> 3) * 3) >> 10;
-      player_ym -= (fast_sin(player_angle >> 3) * 3) >> 10;
+      SDL_AtomicSet(&input_held, (input.left ? INPUT_LEFT : 0) | (input.right ? INPUT_RIGHT : 0) | (input.up ? INPUT_UP : 0) | (input.shift ? INPUT_SHIFT : 0));
+      SDL_AtomicAdd(&input_fire, input.fire);
+      input.fire = 0;
 
-      /* Start thruster sound: */
-      if (use_sound)
+      if (input.stamp)
       {
-        if (!Mix_Playing(CHAN_THRUST))
-        {
-          Mix_PlayChannel(CHAN_THRUST, sounds[SND_THRUST], -1);
-        }
+        /* (If an older change is still waiting, that one is kept.) */
+
+        SDL_AtomicCAS(&input_stamp, 0, input.stamp);
+        input.stamp = 0;
       }
-    }
-    else
-    {
-      /* Slow down (unrealistic, but.. feh!) */
 
-      if (!(counter % 20))
+      if (SDL_AtomicGet(&sim_over))
       {
-        player_xm = (player_xm * 7) / 8;
-        player_ym = (player_ym * 7) / 8;
+        done = true;
+        game_pending = false;
       }
 
-      /* Stop thruster sound: */
+      /* Pick up its latest step, and show the state one step behind
+         real time so there is always a pair to blend between: */
 
-      if (use_sound)
+      if (snapshot_acquire())
       {
-        if (Mix_Playing(CHAN_THRUST))
+        snapshot_copy(&snapshots[0], &snapshots[1]);
+        snapshot_copy(&snapshots[1], &snap_buffers[snap_front]);
+
+        if (snapshots[1].stamp && !present_stamp)
         {
-          Mix_HaltChannel(CHAN_THRUST);
+          present_stamp = snapshots[1].stamp;
         }
       }
-    }
 
-    /* Handle player death: */
+      Uint64 target = SDL_GetPerformanceCounter() - g_sim_period;
 
-    if (!player_alive)
+      if (snapshots[1].time <= snapshots[0].time || target >= snapshots[1].time)
+      {
+        alpha = 256;
+      }
+      else if (target > snapshots[0].time)
+      {
+        alpha = (int32_t)((target - snapshots[0].time) * 256 / (snapshots[1].time - snapshots[0].time));
+      }
+    }
+    else
     {
-      --player_die_timer;
+      /* Run as many fixed steps as real time calls for: */
 
-      if (player_die_timer <= 0)
+      for (size_t n = sim_steps_due(); n > 0 && !done && !pause; --n)
       {
-        if (lives > 0)
-        {
-          /* Reset player: */
-
-          player_die_timer = 0;
-          player_angle = 90;
-          player_x = (kScreenWidth / 2) << 4;
-          player_y = (kScreenHeight / 2) << 4;
-          player_xm = 0;
-          player_ym = 0;
+        /* Optionally pick up input that arrived since the top of the
+           frame, right before it is needed: */
 
-          /* Only bring player back when it's alright to! */
+        if (late_input)
+        {
+          game_events(&input, &done, &quit, &pause);
+        }
 
-          player_alive = 1;
+        Uint32 stamp = input_consume(&input);
 
-          if (!shift_pressed)
-          {
-            for (size_t i = 0; i < kNumAsteroids && player_alive; ++i)
-            {
-              if (asteroids[i].alive)
-              {
-                if (asteroids[i].x >= (player_x >> 4) - (kScreenWidth / 5) && asteroids[i].x <= (player_x >> 4) + (kScreenWidth / 5) && asteroids[i].y >= (player_y >> 4) - (kScreenHeight / 5) && asteroids[i].y <= (player_y >> 4) + (kScreenHeight / 5))
-                {
-                  /* If any asteroid is too close for comfort,
-                     don't bring ship back yet! */
-
-                  player_alive = 0;
-                }
-              }
-            }
-          }
+        if (stamp && !present_stamp)
+        {
+          present_stamp = stamp;
         }
-        else
+
+        if (game_step(&input))
         {
           done = true;
           game_pending = false;
         }
+
+        sounds_play(&input);
+        input.fire = 0;
+
+        snapshot_copy(&snapshots[0], &snapshots[1]);
+        snapshot_take(&snapshots[1], &input);
       }
-    }
 
-    /* Erase screen: */
+      alpha = sim_alpha();
+    }
 
-    SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, 255);
-    SDL_RenderClear(g_renderer);
-    SDL_RenderCopy(g_renderer, g_texture, NULL, NULL);
+    /* Draw, blending between the last two steps: */
 
-    /* Move ship: */
+    game_draw(&snapshots[0], &snapshots[1], alpha);
 
-    player_x += player_xm;
-    player_y += player_ym;
+    /* Flush and pause! */
 
-    /* Wrap ship around edges of screen: */
+    screen_present();
+    g_frame_time = SDL_GetPerformanceCounter() - g_frame_start;
 
-    if (player_x >= (kScreenWidth << 4))
-    {
-      player_x -= (kScreenWidth << 4);
-    }
-    else if (player_x < 0)
+    if (present_stamp)
     {
-      player_x += (kScreenWidth << 4);
+      histogram_add(&latency_present, SDL_GetTicks() - present_stamp);
+      present_stamp = 0;
     }
 
-    if (player_y >= (kScreenHeight << 4))
-    {
-      player_y -= (kScreenHeight << 4);
-    }
-    else if (player_y < 0)
-    {
-      player_y += (kScreenHeight << 4);
-    }
+    frame_sync();
 
-    /* Move bullets: */
+    char titlebar[128];
+    SDL_snprintf(titlebar, sizeof(titlebar), "%s - %.2f ms", kGameName, (double)g_frame_time * 1000.0 / (double)SDL_GetPerformanceFrequency());
+    SDL_SetWindowTitle(g_window, titlebar);
+  }
 
-    for (size_t i = 0; i < kNumBullets; ++i)
-    {
-      if (bullets[i].timer >= 0)
-      {
-        /* Bullet wears out: */
+  sim_end();
 
-        bullets[i].timer--;
+  /* Record, if a high score: */
 
-        /* Move bullet: */
+  if (score >= high)
+  {
+    high = score;
+  }
 
-        bullets[i].x = bullets[i].x + bullets[i].xm;
-        bullets[i].y = bullets[i].y + bullets[i].ym;
+  /* Display mouse cursor: */
 
-        /* Wrap bullet around edges of screen: */
+  if (fullscreen)
+  {
+    SDL_ShowCursor(1);
+  }
 
-        if (bullets[i].x >= kScreenWidth)
-        {
-          bullets[i].x = bullets[i].x - kScreenWidth;
-        }
-        else if (bullets[i].x < 0)
-        {
-          bullets[i].x = bullets[i].x + kScreenWidth;
-        }
+  return (quit);
+}
 
-        if (bullets[i].y >= kScreenHeight)
-        {
-          bullets[i].y = bullets[i].y - kScreenHeight;
-        }
-        else if (bullets[i].y < 0)
-        {
-          bullets[i].y = bullets[i].y + kScreenHeight;
-        }
+/* Step the game as fast as it will go, with nothing drawn or heard, and
+   report the rate.  A simple autopilot keeps turning and firing (with a
+   burst of thrust now and then), and starts a new game whenever one ends: */
 
-        /* Check for collision with any asteroids! */
+void
+headless_run(void)
+{
+  double freq = (double)SDL_GetPerformanceFrequency();
+  size_t games = 1, best = 0;
+  Input input = {0};
 
-        for (size_t j = 0; j < kNumAsteroids; ++j)
-        {
-          if (bullets[i].timer > 0 && asteroids[j].alive)
-          {
-            if ((bullets[i].x + 5 >= asteroids[j].x - asteroids[j].size * kAsteroidsRadius) && (bullets[i].x - 5 <= asteroids[j].x + asteroids[j].size * kAsteroidsRadius) && (bullets[i].y + 5 >= asteroids[j].y - asteroids[j].size * kAsteroidsRadius) && (bullets[i].y - 5 <= asteroids[j].y + asteroids[j].size * kAsteroidsRadius))
-            {
-              /* Remove bullet! */
+  game_reset();
+  sim_counter = 0;
 
-              bullets[i].timer = 0;
+  Uint64 t0 = SDL_GetPerformanceCounter();
 
-              hurt_asteroid(j, bullets[i].xm, bullets[i].ym, asteroids[j].size * 3);
-            }
-          }
-        }
-      }
+  for (size_t n = 0; n < headless_frames; n++)
+  {
+    input.left = true;
+    input.up = (n % 64 < 8);
+    input.fire = !(n % 8);
+
+    if (game_step(&input))
+    {
+      best = (score > best ? score : best);
+      games++;
+      game_reset();
     }
+  }
 
-    /* Move asteroids: */
+  double secs = (SDL_GetPerformanceCounter() - t0) / freq;
 
-    size_t num_asteroids_alive = 0;
+  best = (score > best ? score : best);
 
-    for (size_t i = 0; i < kNumAsteroids; ++i)
-    {
-      if (asteroids[i].alive)
-      {
-        ++num_asteroids_alive;
+  printf("%zu steps in %.3f s: %.0f steps/s (%.3f us/step), "
+         "%zu games, best score %zu\n",
+         headless_frames,
+         secs,
+         headless_frames / secs,
+         secs * 1e6 / headless_frames,
+         games,
+         best);
+}
 
-        /* Move asteroid: */
+/* Read pending events into the game's controls: */
 
-        if (!(counter % 4))
-        {
-          asteroids[i].x = asteroids[i].x + asteroids[i].xm;
-          asteroids[i].y = asteroids[i].y + asteroids[i].ym;
-        }
+void
+game_events(Input* input, bool* done, bool* quit, bool* pause)
+{
+  SDL_Event event = {0};
+  while (SDL_PollEvent(&event) > 0)
+  {
+    Input before = *input;
 
-        /* Wrap asteroid around edges of screen: */
+    if (event.type == SDL_QUIT)
+    {
+      /* Quit! */
 
-        if (asteroids[i].x >= kScreenWidth)
-        {
-          asteroids[i].x = asteroids[i].x - kScreenWidth;
-        }
-        else if (asteroids[i].x < 0)
+      *done = true;
+      *quit = true;
+    }
+    else if (event.type == SDL_KEYDOWN || event.type == SDL_KEYUP)
+    {
+      if (event.type == SDL_KEYDOWN)
+      {
+        switch (event.key.keysym.scancode)
         {
-          asteroids[i].x = asteroids[i].x + kScreenWidth;
-        }
+          case SDL_SCANCODE_ESCAPE:
+            /* Return to menu! */
+            *done = true;
+            break;
 
-        if (asteroids[i].y >= kScreenHeight)
-        {
-          asteroids[i].y = asteroids[i].y - kScreenHeight;
+            /* Key press... */
+          case SDL_SCANCODE_RIGHT:
+            /* Rotate CW */
+            input->left = false;
+            input->right = true;
+            break;
+          case SDL_SCANCODE_LEFT:
+            /* Rotate CCW */
+            input->left = true;
+            input->right = false;
+            break;
+          case SDL_SCANCODE_UP:
+            /* Thrust! */
+            input->up = true;
+            break;
+          case SDL_SCANCODE_SPACE:
+            /* Fire a bullet! (on the next step) */
+            ++input->fire;
+            break;
+          case SDL_SCANCODE_LSHIFT:
+          case SDL_SCANCODE_RSHIFT:
+            /* Respawn now (if applicable) */
+            input->shift = true;
+            break;
+          case SDL_SCANCODE_P:
+          case SDL_SCANCODE_PAUSE:
+            *pause = true;
+            break;
+          default:
+            break;
         }
-        else if (asteroids[i].y < 0)
+      }
+      else if (event.type == SDL_KEYUP)
+      {
+        /* Key release... */
+        switch (event.key.keysym.scancode)
         {
-          asteroids[i].y = asteroids[i].y + kScreenHeight;
+          case SDL_SCANCODE_RIGHT:
+            input->right = false;
+            break;
+          case SDL_SCANCODE_LEFT:
+            input->left = false;
+            break;
+          case SDL_SCANCODE_UP:
+            input->up = false;
+            break;
+          case SDL_SCANCODE_LSHIFT:
+          case SDL_SCANCODE_RSHIFT:
+            /* Respawn now (if applicable) */
+            input->shift = false;
+            break;
+          default:
+            break;
         }
+      }
+    }
+    else if (event.type == SDL_WINDOWEVENT)
+    {
+      /* Nobody is watching; stop until they come back: */
 
-        /* Rotate asteroid: */
+      if (event.window.event == SDL_WINDOWEVENT_FOCUS_LOST || event.window.event == SDL_WINDOWEVENT_MINIMIZED)
+      {
+        *pause = true;
+      }
+    }
+#ifdef JOY_YES
+    else if (event.type == SDL_JOYBUTTONDOWN)
+    {
+      if (event.jbutton.button == JOY_B)
+      {
+        /* Fire a bullet! */
 
-        asteroids[i].angle = (asteroids[i].angle + asteroids[i].angle_m);
+        ++input->fire;
+      }
+      else if (event.jbutton.button == JOY_A)
+      {
+        /* Thrust: */
 
-        /* Wrap rotation angle... */
+        input->up = true;
+      }
+      else
+      {
+        input->shift = true;
+      }
+    }
+    else if (event.type == SDL_JOYBUTTONUP)
+    {
+      if (event.jbutton.button == JOY_A)
+      {
+        /* Stop thrust: */
 
-        if (asteroids[i].angle < 0)
+        input->up = false;
+      }
+      else if (event.jbutton.button != JOY_B)
+      {
+        input->shift = false;
+      }
+    }
+    else if (event.type == SDL_JOYAXISMOTION)
+    {
+      if (event.jaxis.axis == JOY_X)
+      {
+        if (event.jaxis.value < -256)
+        {
+          input->left = true;
+          input->right = false;
+        }
+        else if (event.jaxis.value > 256)
         {
-          asteroids[i].angle = asteroids[i].angle + 360;
+          input->left = false;
+          input->right = true;
         }
-        else if (asteroids[i].angle >= 360)
+        else
         {
-          asteroids[i].angle = asteroids[i].angle - 360;
+          input->left = false;
+          input->right = false;
         }
+      }
+    }
+#endif
 
-        /* See if we collided with the player: */
+    /* Remember when the oldest not-yet-simulated change came in: */
 
-        if (asteroids[i].x >= (player_x >> 4) - kShipRadius && asteroids[i].x <= (player_x >> 4) + kShipRadius && asteroids[i].y >= (player_y >> 4) - kShipRadius && asteroids[i].y <= (player_y >> 4) + kShipRadius && player_alive)
-        {
-          hurt_asteroid(i, player_xm >> 4, player_ym >> 4, kNumBits);
+    if (!input->stamp && (input->left != before.left || input->right != before.right || input->up != before.up || input->shift != before.shift || input->fire != before.fire))
+    {
+      input->stamp = event.common.timestamp;
+    }
+  }
+}
 
-          player_alive = 0;
-          player_die_timer = 30;
+/* The next step is about to see this input; note how long it waited: */
 
-          playsound(SND_EXPLODE);
+Uint32
+input_consume(Input* input)
+{
+  Uint32 stamp = input->stamp;
 
-          /* Stop thruster sound: */
+  if (stamp)
+  {
+    histogram_add(&latency_sim, SDL_GetTicks() - stamp);
+    input->stamp = 0;
+  }
 
-          if (use_sound)
-          {
-            if (Mix_Playing(CHAN_THRUST))
-            {
-              Mix_HaltChannel(CHAN_THRUST);
-            }
-          }
+  return stamp;
+}
 
-          --lives;
+/* Copy what the renderer needs out of the game state: */
 
-          if (!lives)
-          {
-            if (use_sound)
-            {
-              playsound(SND_GAMEOVER);
-              playsound(SND_GAMEOVER);
-              playsound(SND_GAMEOVER);
-              /* Mix_PlayChannel(CHAN_THRUST,
-                 sounds[SND_GAMEOVER], 0); */
-            }
-            player_die_timer = 100;
-          }
-        }
-      }
+void
+snapshot_take(Snapshot* snap, const Input* input)
+{
+  snap->player_x = player_x;
+  snap->player_y = player_y;
+  snap->player_angle = player_angle;
+  snap->player_alive = player_alive;
+  snap->player_die_timer = player_die_timer;
+  snap->thrust = input->up;
+
+  snap->num_bullets = bullet_pool.count;
+  snap->bullets_used = bullet_pool.used;
+  bullets_copy(&snap->bullets, &bullets, bullet_pool.used);
+  memcpy(snap->bullets_live, bullet_pool.live, bullet_pool.count * sizeof(int32_t));
+
+  snap->num_asteroids = asteroid_pool.count;
+  snap->asteroids_used = asteroid_pool.used;
+  asteroids_copy(&snap->asteroids, &asteroids, asteroid_pool.used);
+  memcpy(snap->asteroids_live, asteroid_pool.live, asteroid_pool.count * sizeof(int32_t));
+  memcpy(snap->shapes, shapes, asteroid_pool.used * sizeof(*shapes));
+  memcpy(snap->grid_head, grid_head, grid_cols * grid_rows * sizeof(int32_t));
+  memcpy(snap->grid_next, grid_next, asteroid_pool.used * sizeof(int32_t));
+
+  snap->lives = lives;
+  snap->score = score;
+  snap->level = level;
+  snap->text_zoom = text_zoom;
+  memcpy(snap->zoom_str, zoom_str, sizeof(zoom_str));
+
+  particles_copy(&snap->particles, &particles);
+}
+
+/* Copy a snapshot into another one's tables, leaving the unused ends of
+   them alone: */
+
+void
+snapshot_copy(Snapshot* dst, const Snapshot* src)
+{
+  memcpy(dst, src, offsetof(Snapshot, bullets));
+
+  bullets_copy(&dst->bullets, &src->bullets, src->bullets_used);
+  memcpy(dst->bullets_live, src->bullets_live, src->num_bullets * sizeof(int32_t));
+  asteroids_copy(&dst->asteroids, &src->asteroids, src->asteroids_used);
+  memcpy(dst->asteroids_live, src->asteroids_live, src->num_asteroids * sizeof(int32_t));
+  memcpy(dst->shapes, src->shapes, src->asteroids_used * sizeof(*src->shapes));
+  particles_copy(&dst->particles, &src->particles);
+  memcpy(dst->grid_head, src->grid_head, grid_cols * grid_rows * sizeof(int32_t));
+  memcpy(dst->grid_next, src->grid_next, src->asteroids_used * sizeof(int32_t));
+}
+
+/* Copy the first 'n' slots of one set of tables into another: */
+
+void
+bullets_copy(Bullets* dst, const Bullets* src, size_t n)
+{
+  n *= sizeof(int32_t);
+
+  memcpy(dst->timer, src->timer, n);
+  memcpy(dst->x, src->x, n);
+  memcpy(dst->y, src->y, n);
+  memcpy(dst->xm, src->xm, n);
+  memcpy(dst->ym, src->ym, n);
+}
+
+void
+asteroids_copy(Asteroids* dst, const Asteroids* src, size_t n)
+{
+  n *= sizeof(int32_t);
+
+  memcpy(dst->alive, src->alive, n);
+  memcpy(dst->size, src->size, n);
+  memcpy(dst->x, src->x, n);
+  memcpy(dst->y, src->y, n);
+  memcpy(dst->xm, src->xm, n);
+  memcpy(dst->ym, src->ym, n);
+  memcpy(dst->angle, src->angle, n);
+  memcpy(dst->angle_m, src->angle_m, n);
+}
+
+/* Blend a wrapped coordinate between two steps (alpha is 0..256); a jump
+   longer than 'far' was a respawn or slot reuse, and is not blended: */
+
+int32_t
+lerp_wrap(int32_t from, int32_t to, int32_t alpha, int32_t size, int32_t far)
+{
+  int32_t d = to - from;
+
+  if (d > size / 2)
+  {
+    d -= size;
+  }
+  else if (d < -size / 2)
+  {
+    d += size;
+  }
+
+  if (d > far || d < -far)
+  {
+    return to;
+  }
+
+  int32_t v = from + (d * alpha) / 256;
+
+  if (v >= size)
+  {
+    v -= size;
+  }
+  else if (v < 0)
+  {
+    v += size;
+  }
+
+  return v;
+}
+
+/* Move a world coordinate less than one world away from the camera into
+   view coordinates: */
+
+int32_t
+view_wrap(int32_t v, int32_t lo, int32_t size)
+{
+  v += -(v < lo) & size;
+  v -= -(v >= lo + size) & size;
+
+  return v;
+}
+
+/* Draw the game, 'alpha' (0..256) of the way from one step to the next: */
+
+void
+game_draw(const Snapshot* prev, const Snapshot* cur, int32_t alpha)
+{
+  int32_t px = lerp_wrap(prev->player_x, cur->player_x, alpha, world_w << 4, kLerpFar << 4) >> 4;
+  int32_t py = lerp_wrap(prev->player_y, cur->player_y, alpha, world_h << 4, kLerpFar << 4) >> 4;
+  int32_t cam_x = 0, cam_y = 0;
+
+  if (!prev->player_alive)
+  {
+    px = cur->player_x >> 4;
+    py = cur->player_y >> 4;
+  }
+
+  /* The camera keeps the ship in the middle of the view, unless the whole
+     world fits on the screen: */
+
+  if (world_scale > 1)
+  {
+    cam_x = px - screen_w / 2;
+    cam_y = py - screen_h / 2;
+    cam_x += -(cam_x < 0) & world_w;
+    cam_y += -(cam_y < 0) & world_h;
+  }
+
+  px = view_wrap(px - cam_x, view_lo_x, world_w);
+  py = view_wrap(py - cam_y, view_lo_y, world_h);
+
+  /* Erase screen: */
+
+  screen_clear(true);
+
+  /* Draw ship: */
+
+  if (cur->player_alive)
+  {
+    draw_segment(kShipRadius, 0, mkcolor(128, 128, 255), kShipRadius / 2, 135, mkcolor(0, 0, 192), px, py, cur->player_angle);
+
+    draw_segment(kShipRadius / 2, 135, mkcolor(0, 0, 192), 0, 0, mkcolor(64, 64, 230), px, py, cur->player_angle);
+
+    draw_segment(0, 0, mkcolor(64, 64, 230), kShipRadius / 2, 225, mkcolor(0, 0, 192), px, py, cur->player_angle);
+
+    draw_segment(kShipRadius / 2, 225, mkcolor(0, 0, 192), kShipRadius, 0, mkcolor(128, 128, 255), px, py, cur->player_angle);
+
+    /* Draw flame: */
+
+    if (cur->thrust)
+    {
+      draw_segment(0, 0, mkcolor(255, 255, 255), random_fx(20), 180, mkcolor(255, 0, 0), px, py, cur->player_angle);
     }
+  }
 
-    /* Move bits: */
+  /* Draw bullets: */
 
-    for (size_t i = 0; i < kNumBits; ++i)
+  for (size_t n = 0; n < cur->num_bullets; ++n)
+  {
+    const Bullets* b = &cur->bullets;
+    size_t i = cur->bullets_live[n];
+
+    int32_t bx = lerp_wrap(prev->bullets.x[i], b->x[i], alpha, world_w * kFixOne, kLerpFar * kFixOne) >> kFixShift;
+    int32_t by = lerp_wrap(prev->bullets.y[i], b->y[i], alpha, world_h * kFixOne, kLerpFar * kFixOne) >> kFixShift;
+    int32_t bxm = b->xm[i] / kFixOne, bym = b->ym[i] / kFixOne;
+
+    bx = view_wrap(bx - cam_x, view_lo_x, world_w);
+    by = view_wrap(by - cam_y, view_lo_y, world_h);
+
+    if (bx < -kLerpFar || bx >= screen_w + kLerpFar || by < -kLerpFar || by >= screen_h + kLerpFar)
     {
-      if (bits[i].timer > 0)
-      {
-        /* Countdown bit's lifespan: */
+      continue;
+    }
+
+    /* Each sparkle takes 8 small offsets, 8 larger ones and 8 colors: */
+
+    int32_t d[8], e[8], c[24];
 
-        bits[i].timer--;
+    random_fill(rngstate[RNG_DRAW], d, 8, 3);
+    random_fill(rngstate[RNG_DRAW], e, 8, 5);
+    random_fill(rngstate[RNG_DRAW], c, 24, 3);
 
-        /* Move the bit: */
+    for (size_t k = 0; k < 24; k++)
+    {
+      c[k] *= 128;
+    }
 
-        bits[i].x = bits[i].x + bits[i].xm;
-        bits[i].y = bits[i].y + bits[i].ym;
+    draw_line(bx - d[0] - bxm * 2,
+              by - d[1] - bym * 2,
+              mkcolor(c[0], c[1], c[2]),
+              bx + d[2] - bxm * 2,
+              by + d[3] - bym * 2,
+              mkcolor(c[3], c[4], c[5]));
+
+    draw_line(bx + d[4] - bxm * 2,
+              by - d[5] - bym * 2,
+              mkcolor(c[6], c[7], c[8]),
+              bx - d[6] - bxm * 2,
+              by + d[7] - bym * 2,
+              mkcolor(c[9], c[10], c[11]));
+
+    draw_thick_line(bx - e[0],
+                    by - e[1],
+                    mkcolor(c[12] + 64, c[13] + 64, c[14] + 64),
+                    bx + e[2],
+                    by + e[3],
+                    mkcolor(c[15] + 64, c[16] + 64, c[17] + 64));
+
+    draw_thick_line(bx + e[4],
+                    by - e[5],
+                    mkcolor(c[18] + 64, c[19] + 64, c[20] + 64),
+                    bx - e[6],
+                    by + e[7],
+                    mkcolor(c[21] + 64, c[22] + 64, c[23] + 64));
+  }
 
-        /* Wrap bit around edges of screen: */
+  /* Draw asteroids, from only the grid cells in view and the ring of cells
+     around them (rocks are smaller than a cell), so the cost follows what
+     is on screen rather than how many rocks the world holds: */
 
-        if (bits[i].x >= kScreenWidth)
-        {
-          bits[i].x = bits[i].x - kScreenWidth;
-        }
-        else if (bits[i].x < 0)
-        {
-          bits[i].x = bits[i].x + kScreenWidth;
-        }
+  int32_t cols = screen_w / kGridCell + 3, rows = screen_h / kGridCell + 3;
+  int32_t col0 = grid_index(cam_x - kGridCell, grid_cols), row0 = grid_index(cam_y - kGridCell, grid_rows);
 
-        if (bits[i].y >= kScreenHeight)
+  if (cols > grid_cols)
+  {
+    cols = grid_cols;
+  }
+  if (rows > grid_rows)
+  {
+    rows = grid_rows;
+  }
+
+  for (int32_t row = 0; row < rows; row++)
+  {
+    for (int32_t col = 0; col < cols; col++)
+    {
+      int32_t c = ((row0 + row) % grid_rows) * grid_cols + (col0 + col) % grid_cols;
+
+      for (int32_t i = cur->grid_head[c]; i != -1; i = cur->grid_next[i])
+      {
+        const Asteroids* a = &cur->asteroids;
+        int32_t ax = a->x[i], ay = a->y[i];
+        int32_t r = a->size[i] * kAsteroidsRadius;
+
+        if ((size_t)i < prev->asteroids_used && prev->asteroids.alive[i])
         {
-          bits[i].y = bits[i].y - kScreenHeight;
+          ax = lerp_wrap(prev->asteroids.x[i], ax, alpha, world_w * kFixOne, kLerpFar * kFixOne);
+          ay = lerp_wrap(prev->asteroids.y[i], ay, alpha, world_h * kFixOne, kLerpFar * kFixOne);
         }
-        else if (bits[i].y < 0)
+
+        ax = view_wrap((ax >> kFixShift) - cam_x, view_lo_x, world_w);
+        ay = view_wrap((ay >> kFixShift) - cam_y, view_lo_y, world_h);
+
+        if (ax + r < 0 || ax - r >= screen_w || ay + r < 0 || ay - r >= screen_h)
         {
-          bits[i].y = bits[i].y + kScreenHeight;
+          continue;
         }
+
+        draw_asteroid(a->size[i], ax, ay, a->angle[i], cur->shapes[i], &asteroid_cache[i]);
       }
     }
+  }
+
+  /* Draw particles: */
 
-    /* Draw ship: */
+  particles_draw(&cur->particles, alpha, cam_x, cam_y);
 
-    if (player_alive)
+  /* Draw score: */
+
+  char str[10] = {0};
+
+  sprintf(str, "%.6ld", cur->score);
+  draw_text(str, 3, 3, 14, mkcolor(255, 255, 255));
+  draw_text(str, 4, 4, 14, mkcolor(255, 255, 255));
+
+  /* Level: */
+
+  sprintf(str, "%ld", cur->level);
+  draw_text(str, (screen_w - 14) / 2, 3, 14, mkcolor(255, 255, 255));
+  draw_text(str, (screen_w - 14) / 2 + 1, 4, 14, mkcolor(255, 255, 255));
+
+  /* Draw lives: */
+  size_t k = 0;
+  for (size_t i = 0; i < cur->lives; ++i, ++k)
+  {
+    draw_segment(16, 0, mkcolor(255, 255, 255), 4, 135, mkcolor(255, 255, 255), screen_w - 10 - i * 10, 20, 90);
+
+    draw_segment(8, 135, mkcolor(255, 255, 255), 0, 0, mkcolor(255, 255, 255), screen_w - 10 - i * 10, 20, 90);
+
+    draw_segment(0, 0, mkcolor(255, 255, 255), 8, 225, mkcolor(255, 255, 255), screen_w - 10 - i * 10, 20, 90);
+
+    draw_segment(8, 225, mkcolor(255, 255, 255), 16, 0, mkcolor(255, 255, 255), screen_w - 10 - i * 10, 20, 90);
+  }
+
+  if (cur->player_die_timer > 0)
+  {
+    size_t j = 0;
+
+    if (cur->player_die_timer > 30)
     {
-      draw_segment(kShipRadius, 0, mkcolor(128, 128, 255), kShipRadius / 2, 135, mkcolor(0, 0, 192), player_x >> 4, player_y >> 4, player_angle);
+      j = 30;
+    }
+    else
+    {
+      j = cur->player_die_timer;
+    }
 
-      draw_segment(kShipRadius / 2, 135, mkcolor(0, 0, 192), 0, 0, mkcolor(64, 64, 230), player_x >> 4, player_y >> 4, player_angle);
+    draw_segment((16 * j) / 30, 0, mkcolor(255, 255, 255), (4 * j) / 30, 135, mkcolor(255, 255, 255), screen_w - 10 - k * 10, 20, 90);
 
-      draw_segment(0, 0, mkcolor(64, 64, 230), kShipRadius / 2, 225, mkcolor(0, 0, 192), player_x >> 4, player_y >> 4, player_angle);
+    draw_segment((8 * j) / 30, 135, mkcolor(255, 255, 255), 0, 0, mkcolor(255, 255, 255), screen_w - 10 - k * 10, 20, 90);
 
-      draw_segment(kShipRadius / 2, 225, mkcolor(0, 0, 192), kShipRadius, 0, mkcolor(128, 128, 255), player_x >> 4, player_y >> 4, player_angle);
+    draw_segment(0, 0, mkcolor(255, 255, 255), (8 * j) / 30, 225, mkcolor(255, 255, 255), screen_w - 10 - k * 10, 20, 90);
 
-      /* Draw flame: */
+    draw_segment((8 * j) / 30, 225, mkcolor(255, 255, 255), (16 * j) / 30, 0, mkcolor(255, 255, 255), screen_w - 10 - k * 10, 20, 90);
+  }
 
-      if (up_pressed)
-      {
-        draw_segment(0, 0, mkcolor(255, 255, 255), (random_get() % 20), 180, mkcolor(255, 0, 0), player_x >> 4, player_y >> 4, player_angle);
-      }
+  /* Zooming level effect: */
+
+  if (cur->text_zoom > 0)
+  {
+    draw_text((char*)cur->zoom_str, (screen_w - (strlen(cur->zoom_str) * cur->text_zoom)) / 2, (screen_h - cur->text_zoom) / 2, cur->text_zoom, mkcolor(cur->text_zoom * (256 / kZoomStart), 0, 0));
+  }
+
+  /* Game over? */
+
+  if (!cur->player_alive && !cur->lives)
+  {
+    if (cur->player_die_timer > 14)
+    {
+      draw_text("GAME OVER",
+                (screen_w - 9 * cur->player_die_timer) / 2,
+                (screen_h - cur->player_die_timer) / 2,
+                cur->player_die_timer,
+                mkcolor(random_fx(255),
+                        random_fx(255),
+                        random_fx(255)));
+    }
+    else
+    {
+      draw_text("GAME OVER",
+                (screen_w - 9 * 14) / 2,
+                (screen_h - 14) / 2,
+                14,
+                mkcolor(255, 255, 255));
     }
+  }
+}
+
+/* Fixed-timestep clock: */
+
+void
+sim_clock_reset(void)
+{
+  g_sim_last = SDL_GetPerformanceCounter();
+  g_sim_acc = g_sim_period;
+}
+
+/* How many steps are due since the last call? */
+
+size_t
+sim_steps_due(void)
+{
+  Uint64 now = SDL_GetPerformanceCounter();
+
+  g_sim_acc += now - g_sim_last;
+  g_sim_last = now;
+
+  /* After a long stall, drop time rather than spiral trying to catch up: */
+
+  if (g_sim_acc > g_sim_period * kMaxSimSteps)
+  {
+    g_sim_acc = g_sim_period * kMaxSimSteps;
+  }
+
+  size_t n = g_sim_acc / g_sim_period;
+  g_sim_acc -= n * g_sim_period;
+
+  return n;
+}
+
+/* Start the simulation thread, if we use one: */
+
+void
+sim_start(void)
+{
+  if (!use_threads)
+  {
+    return;
+  }
+
+  snapshot_take(&snap_buffers[0], &(Input){0});
+  snapshot_copy(&snap_buffers[1], &snap_buffers[0]);
+  snapshot_copy(&snap_buffers[2], &snap_buffers[0]);
+  SDL_AtomicSet(&snap_middle, 2);
+  snap_back = 1;
+  snap_front = 0;
+
+  SDL_AtomicSet(&sim_stop, 0);
+  SDL_AtomicSet(&sim_over, 0);
+  SDL_AtomicSet(&input_held, 0);
+  SDL_AtomicSet(&input_fire, 0);
+
+  sim_thread = SDL_CreateThread(sim_run, "sim", NULL);
+  if (!sim_thread)
+  {
+    fprintf(stderr, "SDL_CreateThread: %s\n", SDL_GetError());
+    use_threads = false;
+  }
+}
+
+/* Stop the simulation thread (if running) and wait for it: */
+
+void
+sim_end(void)
+{
+  if (sim_thread)
+  {
+    SDL_AtomicSet(&sim_stop, 1);
+    SDL_WaitThread(sim_thread, NULL);
+    sim_thread = 0;
+  }
+}
 
-    /* Draw bullets: */
+/* Start the job workers: 'count' threads in all (counting the simulation's
+   own), or one per CPU if it is zero: */
+
+void
+jobs_start(size_t count)
+{
+  if (count == 0)
+  {
+    count = SDL_GetCPUCount();
+  }
+  if (count > kMaxWorkers)
+  {
+    count = kMaxWorkers;
+  }
 
-    for (size_t i = 0; i < kNumBullets; ++i)
+  num_workers = 1;
+
+  if (count < 2)
+  {
+    return;
+  }
+
+  jobs_wake = SDL_CreateSemaphore(0);
+  jobs_done = SDL_CreateSemaphore(0);
+  if (!jobs_wake || !jobs_done)
+  {
+    fprintf(stderr, "\nWarning: No job workers (SDL_CreateSemaphore: %s)\n\n", SDL_GetError());
+    return;
+  }
+
+  SDL_AtomicSet(&jobs_stop, 0);
+
+  for (size_t i = 1; i < count; i++)
+  {
+    job_threads[i] = SDL_CreateThread(jobs_worker, "jobs", (void*)(uintptr_t)i);
+    if (!job_threads[i])
     {
-      if (bullets[i].timer >= 0)
-      {
-        draw_line(bullets[i].x - (random_get() % 3) - bullets[i].xm * 2,
-                  bullets[i].y - (random_get() % 3) - bullets[i].ym * 2,
-                  mkcolor((random_get() % 3) * 128,
-                          (random_get() % 3) * 128,
-                          (random_get() % 3) * 128),
-                  bullets[i].x + (random_get() % 3) - bullets[i].xm * 2,
-                  bullets[i].y + (random_get() % 3) - bullets[i].ym * 2,
-                  mkcolor((random_get() % 3) * 128,
-                          (random_get() % 3) * 128,
-                          (random_get() % 3) * 128));
-
-        draw_line(bullets[i].x + (random_get() % 3) - bullets[i].xm * 2,
-                  bullets[i].y - (random_get() % 3) - bullets[i].ym * 2,
-                  mkcolor((random_get() % 3) * 128,
-                          (random_get() % 3) * 128,
-                          (random_get() % 3) * 128),
-                  bullets[i].x - (random_get() % 3) - bullets[i].xm * 2,
-                  bullets[i].y + (random_get() % 3) - bullets[i].ym * 2,
-                  mkcolor((random_get() % 3) * 128,
-                          (random_get() % 3) * 128,
-                          (random_get() % 3) * 128));
-
-        draw_thick_line(bullets[i].x - (random_get() % 5),
-                        bullets[i].y - (random_get() % 5),
-                        mkcolor((random_get() % 3) * 128 + 64,
-                                (random_get() % 3) * 128 + 64,
-                                (random_get() % 3) * 128 + 64),
-                        bullets[i].x + (random_get() % 5),
-                        bullets[i].y + (random_get() % 5),
-                        mkcolor((random_get() % 3) * 128 + 64,
-                                (random_get() % 3) * 128 + 64,
-                                (random_get() % 3) * 128 + 64));
-
-        draw_thick_line(bullets[i].x + (random_get() % 5),
-                        bullets[i].y - (random_get() % 5),
-                        mkcolor((random_get() % 3) * 128 + 64,
-                                (random_get() % 3) * 128 + 64,
-                                (random_get() % 3) * 128 + 64),
-                        bullets[i].x - (random_get() % 5),
-                        bullets[i].y + (random_get() % 5),
-                        mkcolor((random_get() % 3) * 128 + 64,
-                                (random_get() % 3) * 128 + 64,
-                                (random_get() % 3) * 128 + 64));
-      }
+      fprintf(stderr, "\nWarning: Only %zu job workers (SDL_CreateThread: %s)\n\n", i, SDL_GetError());
+      break;
     }
 
-    /* Draw asteroids: */
+    num_workers = i + 1;
+  }
+
+  jobs_run = jobs_parallel;
+}
+
+/* Stop the job workers and wait for them: */
+
+void
+jobs_end(void)
+{
+  SDL_AtomicSet(&jobs_stop, 1);
+
+  for (size_t i = 1; i < num_workers; i++)
+  {
+    SDL_SemPost(jobs_wake);
+  }
+
+  for (size_t i = 1; i < num_workers; i++)
+  {
+    SDL_WaitThread(job_threads[i], NULL);
+    job_threads[i] = 0;
+  }
+
+  if (jobs_wake)
+  {
+    SDL_DestroySemaphore(jobs_wake);
+    jobs_wake = 0;
+  }
+  if (jobs_done)
+  {
+    SDL_DestroySemaphore(jobs_done);
+    jobs_done = 0;
+  }
+
+  num_workers = 1;
+  jobs_run = jobs_serial;
+}
+
+/* Job worker thread: sleeps until jobs are handed out, then runs (and
+   steals) them until there are none left, waking whoever handed them out
+   when it finishes the last one.  In real-time mode, it goes real-time
+   too (on the CPUs after the main and simulation threads'), so it is not
+   left waiting behind everything else while the caller waits on it: */
+
+int
+jobs_worker(void* data)
+{
+  size_t self = (uintptr_t)data;
+  Job job = {0};
 
-    for (size_t i = 0; i < kNumAsteroids; ++i)
+  if (use_realtime)
+  {
+    realtime_thread((realtime_cpu + 1 + self) % SDL_GetCPUCount(), "job worker");
+  }
+
+  while (SDL_SemWait(jobs_wake) == 0 && !SDL_AtomicGet(&jobs_stop))
+  {
+    while (job_take(self, &job))
     {
-      if (asteroids[i].alive)
+      job.fn(job.data, job.begin, job.end);
+
+      if (SDL_AtomicAdd(&jobs_pending, -1) == 1)
       {
-        draw_asteroid(asteroids[i].size,
-                      asteroids[i].x,
-                      asteroids[i].y,
-                      asteroids[i].angle,
-                      asteroids[i].shape);
+        SDL_SemPost(jobs_done);
       }
     }
+  }
+
+  return 0;
+}
+
+/* Take the newest job off our own deque, or else the oldest one off
+   someone else's: */
 
-    /* Draw bits: */
+bool
+job_take(size_t self, Job* job)
+{
+  bool found = false;
+
+  for (size_t k = 0; k < num_workers && !found; k++)
+  {
+    Deque* d = &job_deques[(self + k) % num_workers];
 
-    for (size_t i = 0; i < kNumBits; ++i)
+    SDL_AtomicLock(&d->lock);
+
+    if (d->bottom > d->top)
     {
-      if (bits[i].timer > 0)
-      {
-        draw_line(bits[i].x, bits[i].y, mkcolor(255, 255, 255), bits[i].x + bits[i].xm, bits[i].y + bits[i].ym, mkcolor(255, 255, 255));
-      }
+      *job = (k == 0 ? d->jobs[--d->bottom % kJobQueue] : d->jobs[d->top++ % kJobQueue]);
+      found = true;
     }
 
-    /* Draw score: */
+    SDL_AtomicUnlock(&d->lock);
+  }
 
-    char str[10] = {0};
+  return found;
+}
+
+/* Run fn() over [0, n) in chunks of 'size' and wait for all of them.  The
+   calling thread works (and steals) too; with no workers, or just the one
+   chunk, it simply runs them in order.  Once there is nothing left to
+   take, it spins a little for the workers to finish, then sleeps until
+   they have (rather than spinning on a CPU a preempted worker may need).
+   (This is what the core's jobs_run points at while the workers are up.) */
 
-    sprintf(str, "%.6ld", score);
-    draw_text(str, 3, 3, 14, mkcolor(255, 255, 255));
-    draw_text(str, 4, 4, 14, mkcolor(255, 255, 255));
+void
+jobs_parallel(JobFn fn, void* data, size_t n, size_t size)
+{
+  size_t chunks = (n + size - 1) / size;
+  Job job = {0};
 
-    /* Level: */
+  assert(chunks <= kJobChunks);
+
+  if (num_workers < 2 || chunks < 2)
+  {
+    jobs_serial(fn, data, n, size);
+    return;
+  }
 
-    sprintf(str, "%ld", level);
-    draw_text(str, (kScreenWidth - 14) / 2, 3, 14, mkcolor(255, 255, 255));
-    draw_text(str, (kScreenWidth - 14) / 2 + 1, 4, 14, mkcolor(255, 255, 255));
+  /* (Clear a wakeup left over from last time, when we finished first:) */
 
-    /* Draw lives: */
-    size_t k = 0;
-    for (size_t i = 0; i < lives; ++i, ++k)
+  while (SDL_SemTryWait(jobs_done) == 0)
+  {
+  }
+
+  SDL_AtomicSet(&jobs_pending, chunks);
+
+  for (size_t c = 0; c < chunks; c++)
+  {
+    Deque* d = &job_deques[c % num_workers];
+    size_t begin = c * size;
+
+    SDL_AtomicLock(&d->lock);
+    d->jobs[d->bottom++ % kJobQueue] = (Job){fn, data, begin, (begin + size < n ? begin + size : n)};
+    SDL_AtomicUnlock(&d->lock);
+  }
+
+  for (size_t i = 1; i < num_workers && i < chunks; i++)
+  {
+    SDL_SemPost(jobs_wake);
+  }
+
+  size_t spins = 0;
+
+  while (SDL_AtomicGet(&jobs_pending) > 0)
+  {
+    if (job_take(0, &job))
+    {
+      job.fn(job.data, job.begin, job.end);
+      SDL_AtomicAdd(&jobs_pending, -1);
+      spins = 0;
+    }
+    else if (++spins > kJobSpins)
     {
-      draw_segment(16, 0, mkcolor(255, 255, 255), 4, 135, mkcolor(255, 255, 255), kScreenWidth - 10 - i * 10, 20, 90);
+      SDL_SemWait(jobs_done);
+    }
+  }
+}
 
-      draw_segment(8, 135, mkcolor(255, 255, 255), 0, 0, mkcolor(255, 255, 255), kScreenWidth - 10 - i * 10, 20, 90);
+/* Sit out a pause at next to no CPU: nothing is simulated, and the
+   paused frame is only drawn again when the window needs it: */
 
-      draw_segment(0, 0, mkcolor(255, 255, 255), 8, 225, mkcolor(255, 255, 255), kScreenWidth - 10 - i * 10, 20, 90);
+void
+game_pause(const Snapshot* snap, bool* done, bool* quit)
+{
+  bool paused = true;
+  bool redraw = true;
+
+  if (use_sound)
+  {
+    Mix_Pause(-1);
+    Mix_PauseMusic();
+  }
 
-      draw_segment(8, 225, mkcolor(255, 255, 255), 16, 0, mkcolor(255, 255, 255), kScreenWidth - 10 - i * 10, 20, 90);
+  while (paused)
+  {
+    if (redraw && !(SDL_GetWindowFlags(g_window) & SDL_WINDOW_MINIMIZED))
+    {
+      game_draw(snap, snap, 256);
+      draw_centered_text("PAUSED", (screen_h - 14) / 2, 14, mkcolor(255, 255, 255));
+      screen_present();
+      redraw = false;
     }
 
-    if (player_die_timer > 0)
+    SDL_Event event = {0};
+    if (!SDL_WaitEventTimeout(&event, kPauseWaitMs))
     {
-      size_t j = 0;
+      continue;
+    }
 
-      if (player_die_timer > 30)
+    if (event.type == SDL_QUIT)
+    {
+      *done = true;
+      *quit = true;
+      paused = false;
+    }
+    else if (event.type == SDL_KEYDOWN)
+    {
+      switch (event.key.keysym.scancode)
       {
-        j = 30;
+        case SDL_SCANCODE_ESCAPE:
+          /* Return to menu! */
+          *done = true;
+          paused = false;
+          break;
+        case SDL_SCANCODE_P:
+        case SDL_SCANCODE_PAUSE:
+          paused = false;
+          break;
+        default:
+          break;
       }
-      else
+    }
+    else if (event.type == SDL_WINDOWEVENT)
+    {
+      if (event.window.event == SDL_WINDOWEVENT_EXPOSED || event.window.event == SDL_WINDOWEVENT_RESTORED || event.window.event == SDL_WINDOWEVENT_SHOWN)
       {
-        j = player_die_timer;
+        redraw = true;
       }
+    }
+  }
 
-      draw_segment((16 * j) / 30, 0, mkcolor(255, 255, 255), (4 * j) / 30, 135, mkcolor(255, 255, 255), kScreenWidth - 10 - k * 10, 20, 90);
+  if (use_sound)
+  {
+    Mix_Resume(-1);
+    Mix_ResumeMusic();
+  }
+}
 
-      draw_segment((8 * j) / 30, 135, mkcolor(255, 255, 255), 0, 0, mkcolor(255, 255, 255), kScreenWidth - 10 - k * 10, 20, 90);
+/* Wait until 1/fps after the frame started, but wake up at once if any
+   input arrives (the event stays queued for the caller): */
 
-      draw_segment(0, 0, mkcolor(255, 255, 255), (8 * j) / 30, 225, mkcolor(255, 255, 255), kScreenWidth - 10 - k * 10, 20, 90);
+void
+idle_wait(Uint32 fps)
+{
+  Uint64 freq = SDL_GetPerformanceFrequency();
+  Uint64 end = g_frame_start + freq / fps;
+  Uint64 now = SDL_GetPerformanceCounter();
 
-      draw_segment((8 * j) / 30, 225, mkcolor(255, 255, 255), (16 * j) / 30, 0, mkcolor(255, 255, 255), kScreenWidth - 10 - k * 10, 20, 90);
-    }
+  if (now < end)
+  {
+    SDL_WaitEventTimeout(NULL, (int)((end - now) * 1000 / freq));
+  }
 
-    /* Zooming level effect: */
+  frame_sync_reset();
+}
 
-    if (text_zoom > 0)
-    {
-      if (!(counter % 2))
-      {
-        --text_zoom;
-      }
+/* Simulation thread: steps the game at the fixed rate and publishes a
+   snapshot after every step, until told to stop or the game is over: */
+
+int
+sim_run(void* data)
+{
+  (void)data;
 
-      draw_text(zoom_str, (kScreenWidth - (strlen(zoom_str) * text_zoom)) / 2, (kScreenHeight - text_zoom) / 2, text_zoom, mkcolor(text_zoom * (256 / kZoomStart), 0, 0));
+  Input input = {0};
+
+  if (use_realtime)
+  {
+    /* Put the simulation next to the main thread, not on top of it: */
+
+    realtime_thread((realtime_cpu + 1) % SDL_GetCPUCount(), "simulation");
+  }
+
+  sim_clock_reset();
+
+  while (!SDL_AtomicGet(&sim_stop))
+  {
+    size_t n = sim_steps_due();
+
+    if (n == 0)
+    {
+      SDL_Delay(1);
+      continue;
     }
 
-    /* Game over? */
+    /* Time of the most recent step boundary that is now due: */
 
-    if (!player_alive && !lives)
+    Uint64 base = SDL_GetPerformanceCounter() - g_sim_acc;
+
+    for (size_t k = 0; k < n; ++k)
     {
-      if (player_die_timer > 14)
-      {
-        draw_text("GAME OVER",
-                  (kScreenWidth - 9 * player_die_timer) / 2,
-                  (kScreenHeight - player_die_timer) / 2,
-                  player_die_timer,
-                  mkcolor(random_get() % 255,
-                          random_get() % 255,
-                          random_get() % 255));
-      }
-      else
+      int held = SDL_AtomicGet(&input_held);
+
+      input.left = (held & INPUT_LEFT);
+      input.right = (held & INPUT_RIGHT);
+      input.up = (held & INPUT_UP);
+      input.shift = (held & INPUT_SHIFT);
+      input.fire = SDL_AtomicSet(&input_fire, 0);
+      input.stamp = SDL_AtomicSet(&input_stamp, 0);
+
+      Uint32 stamp = input_consume(&input);
+      bool over = game_step(&input);
+
+      sounds_play(&input);
+
+      snapshot_take(&snap_buffers[snap_back], &input);
+      snap_buffers[snap_back].time = base - (n - 1 - k) * g_sim_period;
+      snap_buffers[snap_back].stamp = (snap_carry ? snap_carry : stamp);
+      snap_carry = 0;
+      snapshot_publish();
+
+      if (over)
       {
-        draw_text("GAME OVER",
-                  (kScreenWidth - 9 * 14) / 2,
-                  (kScreenHeight - 14) / 2,
-                  14,
-                  mkcolor(255, 255, 255));
+        SDL_AtomicSet(&sim_over, 1);
+        return 0;
       }
     }
+  }
 
-    /* Go to next level? */
+  return 0;
+}
 
-    if (!num_asteroids_alive)
-    {
-      ++level;
+/* Lock-free triple buffer: the writer swaps its finished back buffer
+   with the shared middle one (flagging it fresh), the reader swaps its
+   front buffer for the middle one only when something fresh is there.
+   A snapshot can be replaced before it was ever read; its input stamp is
+   then carried into the next one, so no latency sample goes missing (one
+   stamp per snapshot, the oldest input wins): */
 
-      reset_level();
-    }
+void
+snapshot_publish(void)
+{
+  int32_t old = SDL_AtomicSet(&snap_middle, snap_back | kSnapFresh);
 
-    /* Flush and pause! */
-    g_frame_time = SDL_GetTicks64() - g_frame_start;
+  snap_back = old & 3;
 
-    if (kFrameDelay > g_frame_time)
-    {
-      SDL_Delay(kFrameDelay - g_frame_time);
-    }
+  if ((old & kSnapFresh) && snap_buffers[snap_back].stamp)
+  {
+    snap_carry = snap_buffers[snap_back].stamp;
+  }
+}
 
-    SDL_RenderPresent(g_renderer);
+bool
+snapshot_acquire(void)
+{
+  if (!(SDL_AtomicGet(&snap_middle) & kSnapFresh))
+  {
+    return false;
+  }
 
-    char titlebar[128];
-    SDL_snprintf(titlebar, sizeof(titlebar), "%ld, %ld", g_frame_start, g_frame_time);
-    SDL_SetWindowTitle(g_window, titlebar);
+  snap_front = SDL_AtomicSet(&snap_middle, snap_front) & 3;
+  return true;
+}
+
+/* How far (0..256) we are between the last step and the next: */
+
+int32_t
+sim_alpha(void)
+{
+  return (int32_t)(g_sim_acc * 256 / g_sim_period);
+}
+
+void
+finish(void)
+{
+  if (show_latency)
+  {
+    histogram_print(stdout, "Input to simulation", &latency_sim);
+    histogram_print(stdout, "Input to present", &latency_present);
   }
 
-  /* Record, if a high score: */
+  if (show_latency || use_realtime)
+  {
+    printf("Missed frame deadlines: %zu of %zu frames\n", frames_missed, frames_timed);
+  }
 
-  if (score >= high)
+  /* Let whoever tunes the capacities know if they were too small: */
+
+  if (asteroid_pool.dropped)
   {
-    high = score;
+    printf("Asteroid pool exhausted: %zu spawns dropped\n", asteroid_pool.dropped);
   }
 
-  /* Display mouse cursor: */
+  if (particles_dropped)
+  {
+    printf("Particle pool exhausted: %zu particles dropped\n", particles_dropped);
+  }
 
-  if (fullscreen)
+  if (events_dropped)
   {
-    SDL_ShowCursor(1);
+    printf("Event ring overflowed: %zu events dropped\n", events_dropped);
   }
 
-  return (quit);
-}
+  free(g_pixels);
+  free(g_background);
+  jobs_end();
+  free(arena.base);
+
+  SDL_Quit();
+}
+
+void
+setup(const int argc, const char* argv[])
+{
+  /* Capacities come from the config file, unless overridden below: */
+
+  config_load(user_file_path_get("vectoroids.conf"), false);
+
+  /* Check command-line options: */
+
+  for (size_t i = 1; i < (size_t)argc; i++)
+  {
+    if (strcmp(argv[i], "--fullscreen") == 0 || strcmp(argv[i], "-f") == 0)
+    {
+      fullscreen = true;
+    }
+    else if (strcmp(argv[i], "--nosound") == 0 || strcmp(argv[i], "-q") == 0)
+    {
+      use_sound = false;
+    }
+    else if (strcmp(argv[i], "--rgb565") == 0 || strcmp(argv[i], "-r") == 0)
+    {
+      use_rgb565 = true;
+    }
+    else if (strcmp(argv[i], "--threaded") == 0 || strcmp(argv[i], "-t") == 0)
+    {
+      use_threads = true;
+    }
+    else if (strcmp(argv[i], "--latency") == 0 || strcmp(argv[i], "-l") == 0)
+    {
+      show_latency = true;
+    }
+    else if (strcmp(argv[i], "--late-input") == 0)
+    {
+      late_input = true;
+    }
+    else if (strcmp(argv[i], "--bounce") == 0)
+    {
+      bounce_rocks = true;
+    }
+    else if (strcmp(argv[i], "--headless") == 0)
+    {
+      headless = true;
+    }
+    else if (strcmp(argv[i], "--frames") == 0 && i + 1 < (size_t)argc)
+    {
+      char* end = NULL;
+      unsigned long long v = strtoull(argv[i + 1], &end, 0);
+
+      if (end == argv[i + 1] || *end != '\0' || argv[i + 1][0] == '-' || v == 0)
+      {
+        fprintf(stderr, "\nError: Bad value for %s: %s\n\n", argv[i], argv[i + 1]);
+        exit(1);
+      }
+
+      headless_frames = v;
+      ++i;
+    }
+    else if (strcmp(argv[i], "--seed") == 0 && i + 1 < (size_t)argc)
+    {
+      char* end = NULL;
+      unsigned long long v = strtoull(argv[i + 1], &end, 0);
 
-void
-finish(void)
-{
-  SDL_Quit();
-}
+      if (end == argv[i + 1] || *end != '\0' || argv[i + 1][0] == '-')
+      {
+        fprintf(stderr, "\nError: Bad value for %s: %s\n\n", argv[i], argv[i + 1]);
+        exit(1);
+      }
 
-void
-setup(const int argc, const char* argv[])
-{
-  /* Check command-line options: */
+      use_seed = true;
+      game_seed = v;
+      ++i;
+    }
+    else if (strcmp(argv[i], "--realtime") == 0)
+    {
+      use_realtime = true;
+    }
+    else if (strcmp(argv[i], "--cpu") == 0 && i + 1 < (size_t)argc)
+    {
+      char* end = NULL;
+      unsigned long v = strtoul(argv[i + 1], &end, 10);
 
-  for (size_t i = 1; i < (size_t)argc; i++)
-  {
-    if (strcmp(argv[i], "--fullscreen") == 0 || strcmp(argv[i], "-f") == 0)
+      if (end == argv[i + 1] || *end != '\0' || argv[i + 1][0] == '-' || v >= (unsigned long)SDL_GetCPUCount())
+      {
+        fprintf(stderr, "\nError: Bad value for %s: %s\n\n", argv[i], argv[i + 1]);
+        exit(1);
+      }
+
+      realtime_cpu = (int32_t)v;
+      ++i;
+    }
+    else if ((strcmp(argv[i], "--bullets") == 0 || strcmp(argv[i], "--asteroids") == 0 || strcmp(argv[i], "--particles") == 0 || strcmp(argv[i], "--stress") == 0 || strcmp(argv[i], "--jobs") == 0 || strcmp(argv[i], "--world") == 0 || strcmp(argv[i], "--size") == 0) && i + 1 < (size_t)argc)
     {
-      fullscreen = true;
+      if (!config_set(argv[i] + 2, argv[i + 1]))
+      {
+        fprintf(stderr, "\nError: Bad value for %s: %s\n\n", argv[i], argv[i + 1]);
+        exit(1);
+      }
+      ++i;
     }
-    else if (strcmp(argv[i], "--nosound") == 0 || strcmp(argv[i], "-q") == 0)
+    else if (strcmp(argv[i], "--config") == 0 && i + 1 < (size_t)argc)
     {
-      use_sound = false;
+      if (!config_load(argv[++i], true))
+      {
+        exit(1);
+      }
+    }
+    else if ((strcmp(argv[i], "--sync") == 0 || strcmp(argv[i], "-s") == 0) && i + 1 < (size_t)argc)
+    {
+      ++i;
+
+      if (strcmp(argv[i], "vsync") == 0)
+      {
+        sync_mode = SYNC_VSYNC;
+      }
+      else if (strcmp(argv[i], "limit") == 0)
+      {
+        sync_mode = SYNC_LIMIT;
+      }
+      else if (strcmp(argv[i], "off") == 0)
+      {
+        sync_mode = SYNC_OFF;
+      }
+      else
+      {
+        show_usage(stderr, argv[0]);
+        exit(1);
+      }
     }
     else if (strcmp(argv[i], "--help") == 0 || strcmp(argv[i], "-h") == 0)
     {
@@ -1663,6 +2536,7 @@ setup(const int argc, const char* argv[])
              "  Up         - Thrust engines\n"
              "  Space      - Fire weapons\n"
              "  Shift      - Respawn after death (or wait)\n"
+             "  P, Pause   - Pause\n"
              "  Escape     - Return to title screen\n"
              "\n"
              "Joystick controls:\n"
@@ -1705,6 +2579,16 @@ setup(const int argc, const char* argv[])
              "\n");
       exit(0);
     }
+    else if (strcmp(argv[i], "--bench-trig") == 0)
+    {
+      trig_bench();
+      exit(0);
+    }
+    else if (strcmp(argv[i], "--bench-rocks") == 0)
+    {
+      rocks_bench();
+      exit(0);
+    }
     else if (strcmp(argv[i], "--usage") == 0 || strcmp(argv[i], "-u") == 0)
     {
       show_usage(stdout, argv[0]);
@@ -1717,6 +2601,55 @@ setup(const int argc, const char* argv[])
     }
   }
 
+  /* Leave room for a stress swarm to break up (plus one, as a rock's two
+     halves are added before it goes away), then allocate the entity tables
+     once and for all: */
+
+  if (stress_rocks && max_asteroids < stress_rocks * kStressSplits + 1)
+  {
+    max_asteroids = stress_rocks * kStressSplits + 1;
+  }
+
+  if (use_seed)
+  {
+    random_seed(game_seed);
+  }
+  else
+  {
+    random_setup();
+  }
+
+  /* (The job workers place themselves around the main thread's CPU in
+     real-time mode, so settle which one that is first:) */
+
+  if (use_realtime && realtime_cpu < 0)
+  {
+    realtime_cpu = SDL_GetCPUCount() - 1;
+  }
+
+  /* (Nothing is drawn headless, so there are no snapshots or outline
+     caches to make room for:) */
+
+  if (!headless)
+  {
+    tables_extra = view_alloc;
+  }
+
+  core_init();
+  jobs_start(job_workers);
+
+  view_lo_x = (screen_w - world_w) / 2;
+  view_lo_y = (screen_h - world_h) / 2;
+
+  /* Without a display, just run the simulation and leave: */
+
+  if (headless)
+  {
+    headless_run();
+    finish();
+    exit(0);
+  }
+
   /* Init SDL video: */
 
   if (SDL_Init(SDL_INIT_VIDEO) < 0)
@@ -1802,7 +2735,7 @@ setup(const int argc, const char* argv[])
 
   /* Open window: */
 
-  g_window = SDL_CreateWindow(kGameName " v" kGameVersion, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, kScreenWidth, kScreenHeight, SDL_WINDOW_SHOWN | SDL_WINDOW_ALLOW_HIGHDPI);
+  g_window = SDL_CreateWindow(kGameName " v" kGameVersion, SDL_WINDOWPOS_UNDEFINED, SDL_WINDOWPOS_UNDEFINED, screen_w, screen_h, SDL_WINDOW_SHOWN | SDL_WINDOW_ALLOW_HIGHDPI);
 
   if (!g_window)
   {
@@ -1813,7 +2746,7 @@ setup(const int argc, const char* argv[])
 
   SDL_SetWindowFullscreen(g_window, fullscreen ? SDL_WINDOW_FULLSCREEN_DESKTOP : 0);
 
-  g_renderer = SDL_CreateRenderer(g_window, -1, SDL_RENDERER_ACCELERATED | SDL_RENDERER_PRESENTVSYNC);
+  g_renderer = SDL_CreateRenderer(g_window, -1, SDL_RENDERER_ACCELERATED | (sync_mode == SYNC_VSYNC ? SDL_RENDERER_PRESENTVSYNC : 0));
   if (!g_renderer)
   {
     fprintf(stderr, "Renderer creation error; %s\n", SDL_GetError());
@@ -1824,19 +2757,15 @@ setup(const int argc, const char* argv[])
 
   /* Load background image: */
 
-  g_texture = IMG_LoadTexture(g_renderer, DATA_PREFIX "images/redspot.jpg");
+  load_background();
 
-  if (!g_texture)
-  {
-    fprintf(stderr,
-            "\nError: I could not open the background image:\n" DATA_PREFIX "images/redspot.jpg\n"
-            "The Simple DirectMedia error that occured was:\n"
-            "%s\n\n",
-            SDL_GetError());
-    exit(1);
-  }
+  SDL_RenderSetLogicalSize(g_renderer, screen_w, screen_h);
 
-  SDL_RenderSetLogicalSize(g_renderer, kScreenWidth, kScreenHeight);
+  /* Set up frame pacing: */
+
+  g_frame_period = SDL_GetPerformanceFrequency() / kScreenFPS;
+  g_sim_period = SDL_GetPerformanceFrequency() / kScreenFPS;
+  g_frame_deadline = SDL_GetPerformanceCounter();
 
   /* Init sound: */
 
@@ -1887,9 +2816,220 @@ setup(const int argc, const char* argv[])
       exit(1);
     }
   }
+
+  /* Go real-time, if asked to: */
+
+  if (use_realtime)
+  {
+    realtime_setup();
+  }
+}
+
+/* Wait for the next frame deadline (only with "--sync limit"; VSYNC
+   already paces SDL_RenderPresent, and "--sync off" runs flat out): */
+
+void
+frame_sync(void)
+{
+  Uint64 now = SDL_GetPerformanceCounter();
+
+  if (sync_mode != SYNC_LIMIT)
+  {
+    /* Count frames that took half a frame longer than they should: */
+
+    if (g_frame_last)
+    {
+      ++frames_timed;
+
+      if (now - g_frame_last > g_frame_period + g_frame_period / 2)
+      {
+        ++frames_missed;
+      }
+    }
+
+    g_frame_deadline = now;
+    g_frame_last = now;
+    return;
+  }
+
+  g_frame_deadline += g_frame_period;
+
+  if (g_frame_last)
+  {
+    ++frames_timed;
+  }
+  g_frame_last = g_frame_deadline;
+
+  if (now >= g_frame_deadline)
+  {
+    /* Running late; resync rather than rushing out a burst of frames: */
+
+    ++frames_missed;
+
+    if (now - g_frame_deadline > g_frame_period)
+    {
+      g_frame_deadline = now;
+    }
+    return;
+  }
+
+  /* Sleep through most of the wait, then spin for the last stretch: */
+
+  Uint64 freq = SDL_GetPerformanceFrequency();
+  Uint64 spin = freq * kFrameSpinUs / 1000000;
+
+  while (now < g_frame_deadline)
+  {
+    Uint64 left = g_frame_deadline - now;
+
+    if (left > spin)
+    {
+      SDL_Delay((left - spin) * 1000 / freq);
+    }
+
+    now = SDL_GetPerformanceCounter();
+  }
+}
+
+/* Start frame pacing afresh (after a pause, or an idle wait): */
+
+void
+frame_sync_reset(void)
+{
+  g_frame_deadline = SDL_GetPerformanceCounter();
+  g_frame_last = 0;
+}
+
+/* Real-time mode: pin the main thread to a CPU, ask for a real-time
+   scheduling class, and lock (and prefault) our memory, saying clearly
+   whenever the kernel refuses: */
+
+void
+realtime_setup(void)
+{
+#ifdef LINUX
+  realtime_thread(realtime_cpu, "main");
+
+  if (mlockall(MCL_CURRENT | MCL_FUTURE))
+  {
+    fprintf(stderr,
+            "\nWarning: I could not lock memory (mlockall): %s\n"
+            "(Try raising RLIMIT_MEMLOCK, e.g. \"ulimit -l unlimited\".)\n\n",
+            strerror(errno));
+  }
+
+  /* Touch every page we will use while playing: */
+
+  prefault(arena.base, arena.size);
+  prefault(snapshots, sizeof(snapshots));
+  prefault(snap_buffers, sizeof(snap_buffers));
+
+  if (use_rgb565)
+  {
+    prefault(g_pixels, screen_w * screen_h * sizeof(uint16_t));
+    prefault(g_background, screen_w * screen_h * sizeof(uint16_t));
+  }
+#else
+  fprintf(stderr, "\nWarning: Real-time mode is only supported on Linux.\n\n");
+#endif
+}
+
+/* Pin the calling thread to a CPU and make it real-time, if allowed: */
+
+void
+realtime_thread(int32_t cpu, const char* name)
+{
+#ifdef LINUX
+  cpu_set_t set;
+
+  CPU_ZERO(&set);
+  CPU_SET(cpu, &set);
+
+  if (sched_setaffinity(0, sizeof(set), &set))
+  {
+    fprintf(stderr, "\nWarning: I could not pin the %s thread to CPU %d: %s\n\n", name, cpu, strerror(errno));
+  }
+
+  struct sched_param param = {0};
+
+  param.sched_priority = sched_get_priority_min(SCHED_FIFO) + 1;
+
+  if (sched_setscheduler(0, SCHED_FIFO, &param))
+  {
+    int fifo_errno = errno;
+
+    param.sched_priority = sched_get_priority_min(SCHED_RR) + 1;
+
+    if (sched_setscheduler(0, SCHED_RR, &param))
+    {
+      fprintf(stderr,
+              "\nWarning: The kernel denied real-time scheduling for the %s thread\n"
+              "(SCHED_FIFO: %s; SCHED_RR: %s).\n"
+              "(It needs CAP_SYS_NICE, or an RLIMIT_RTPRIO above zero.)\n\n",
+              name,
+              strerror(fifo_errno),
+              strerror(errno));
+    }
+  }
+#else
+  (void)cpu;
+  (void)name;
+#endif
+}
+
+/* Fault in (and dirty) every page of a block of memory, keeping its
+   contents: */
+
+void
+prefault(void* p, size_t size)
+{
+  volatile uint8_t* b = p;
+
+  for (size_t i = 0; i < size; i += 4096)
+  {
+    b[i] = b[i];
+  }
+}
+
+/* Carve out the renderer's tables: the asteroid outline caches, and those
+   of every snapshot (the triple buffer's only with --threaded): */
+
+void
+view_alloc(void)
+{
+  asteroid_cache = arena_alloc(max_asteroids * sizeof(AsteroidCache));
+
+  for (size_t i = 0; i < 2; i++)
+  {
+    snapshot_alloc(&snapshots[i]);
+  }
+
+  if (!use_threads)
+  {
+    return;
+  }
+
+  for (size_t i = 0; i < 3; i++)
+  {
+    snapshot_alloc(&snap_buffers[i]);
+  }
+}
+
+void
+snapshot_alloc(Snapshot* snap)
+{
+  bullets_alloc(&snap->bullets, max_bullets);
+  snap->bullets_live = arena_alloc(max_bullets * sizeof(int32_t));
+  asteroids_alloc(&snap->asteroids, max_asteroids);
+  snap->asteroids_live = arena_alloc(max_asteroids * sizeof(int32_t));
+  snap->shapes = arena_alloc(max_asteroids * sizeof(*snap->shapes));
+  particles_alloc(&snap->particles, max_particles);
+  snap->grid_head = arena_alloc(grid_cols * grid_rows * sizeof(int32_t));
+  snap->grid_next = arena_alloc(max_asteroids * sizeof(int32_t));
 }
 
-/* Fast approximate-integer, table-based cosine! Whee! */
+/* Fast approximate-integer, table-based cosine! Whee!  (The game now uses
+   trig_cos() and trig_sin(); these stay for --bench-trig to compare against.) */
 
 int32_t
 fast_cos(int32_t angle)
@@ -1922,30 +3062,205 @@ fast_sin(int32_t angle)
   return (-fast_cos((angle + 11) % 45));
 }
 
-/* Draw a line: */
+/* Exact sine of a fraction of a turn, for measuring the tables against.  The
+   series is summed until it stops changing, so it is only for benchmarks: */
+
+double
+trig_exact(double turns)
+{
+  double q = (turns - (double)(int64_t)turns) * 4.0;
+  double x = 0.0, term = 0.0, sum = 0.0;
+  int32_t quadrant = 0;
+
+  if (q < 0.0)
+  {
+    q += 4.0;
+  }
+
+  quadrant = (int32_t)q;
+  x = (q - quadrant) * 1.57079632679489661923;
+
+  if (quadrant & 1)
+  {
+    x = 1.57079632679489661923 - x;
+  }
+
+  term = x;
+
+  for (int32_t k = 1; sum + term != sum; k += 2)
+  {
+    sum += term;
+    term *= -x * x / ((k + 1) * (k + 2));
+  }
+
+  return ((quadrant & 2) ? -sum : sum);
+}
+
+double
+trig_error(double a, double b)
+{
+  return ((a > b) ? a - b : b - a);
+}
+
+/* Accuracy and throughput of the old 45-step lookups against the new tables,
+   over whole degrees, which is what the game feeds them: */
+
+void
+trig_bench(void)
+{
+  enum { kRounds = 4096, kBatch = 360 };
+  static int32_t deg[kBatch], bin[kBatch], s[kBatch], c[kBatch];
+  double err_old = 0.0, err_new = 0.0, max_old = 0.0, max_new = 0.0, max_table = 0.0;
+  double freq = (double)SDL_GetPerformanceFrequency();
+  volatile int32_t sink = 0;
+  int32_t acc = 0;
+  Uint64 t0 = 0;
+  double ns_old = 0.0, ns_new = 0.0, ns_batch = 0.0;
+
+  for (int32_t i = 0; i < kBatch; i++)
+  {
+    double es = trig_exact(i / 360.0), ec = trig_exact(i / 360.0 + 0.25);
+    double os = trig_error(fast_sin(i >> 3) / 1024.0, es), oc = trig_error(fast_cos(i >> 3) / 1024.0, ec);
+    double ns = trig_error((double)trig_sin(trig_deg(i)) / kTrigOne, es), nc = trig_error((double)trig_cos(trig_deg(i)) / kTrigOne, ec);
+
+    deg[i] = i;
+    bin[i] = trig_deg(i);
+    err_old += os + oc;
+    err_new += ns + nc;
+    max_old = (os > max_old) ? os : max_old;
+    max_old = (oc > max_old) ? oc : max_old;
+    max_new = (ns > max_new) ? ns : max_new;
+    max_new = (nc > max_new) ? nc : max_new;
+  }
+
+  for (int32_t i = 0; i < kTrigSize + kTrigSize / 4; i++)
+  {
+    double e = trig_error(sin_table[i], trig_exact((double)i / kTrigSize) * kTrigOne);
+
+    max_table = (e > max_table) ? e : max_table;
+  }
+
+  /* Throughput, per sine and cosine pair: */
+
+  t0 = SDL_GetPerformanceCounter();
+
+  for (int32_t r = 0; r < kRounds; r++)
+  {
+    for (int32_t i = 0; i < kBatch; i++)
+    {
+      acc += fast_cos(deg[i] >> 3) + fast_sin(deg[i] >> 3);
+    }
+
+    sink = acc;
+  }
+
+  ns_old = (SDL_GetPerformanceCounter() - t0) * 1e9 / freq / ((double)kRounds * kBatch);
+  t0 = SDL_GetPerformanceCounter();
+
+  for (int32_t r = 0; r < kRounds; r++)
+  {
+    for (int32_t i = 0; i < kBatch; i++)
+    {
+      acc += trig_cos(trig_deg(deg[i])) + trig_sin(trig_deg(deg[i]));
+    }
+
+    sink = acc;
+  }
+
+  ns_new = (SDL_GetPerformanceCounter() - t0) * 1e9 / freq / ((double)kRounds * kBatch);
+  t0 = SDL_GetPerformanceCounter();
+
+  for (int32_t r = 0; r < kRounds; r++)
+  {
+    trig_sincos(bin, s, c, kBatch);
+    sink = s[r % kBatch] + c[r % kBatch];
+  }
+
+  ns_batch = (SDL_GetPerformanceCounter() - t0) * 1e9 / freq / ((double)kRounds * kBatch);
+  (void)sink;
+
+  printf("Trig accuracy over 0-359 degrees (1.0 = full scale):\n"
+         "  fast_cos/fast_sin (45 steps)   max %.6f  mean %.6f\n"
+         "  trig_cos/trig_sin (%d steps) max %.6f  mean %.6f\n"
+         "  sin_table entries              max %.3f LSB of Q1.14\n"
+         "Trig throughput (ns per sine and cosine pair):\n"
+         "  fast_cos/fast_sin  %.2f\n"
+         "  trig_cos/trig_sin  %.2f\n"
+         "  trig_sincos batch  %.2f\n",
+         max_old,
+         err_old / (2 * kBatch),
+         kTrigSize,
+         max_new,
+         err_new / (2 * kBatch),
+         max_table,
+         ns_old,
+         ns_new,
+         ns_batch);
+}
+
+/* Draw a line: */
+
+void
+draw_line(int32_t x1, int32_t y1, SDL_Color c1, int32_t x2, int32_t y2, SDL_Color c2)
+{
+  int32_t lines[3][4] = {0};
+  size_t n = wrap_line(x1, y1, x2, y2, lines);
+
+  for (size_t i = 0; i < n; i++)
+  {
+    sdl_drawline(lines[i][0], lines[i][1], c1, lines[i][2], lines[i][3], c2);
+  }
+}
+
+/* Split a line (in view coordinates) into the copies needed to wrap around
+   the edges of the world: */
 
-void
-draw_line(int32_t x1, int32_t y1, SDL_Color c1, int32_t x2, int32_t y2, SDL_Color c2)
+size_t
+wrap_line(int32_t x1, int32_t y1, int32_t x2, int32_t y2, int32_t lines[3][4])
 {
-  sdl_drawline(x1, y1, c1, x2, y2, c2);
+  size_t n = 0;
+
+  lines[n][0] = x1;
+  lines[n][1] = y1;
+  lines[n][2] = x2;
+  lines[n][3] = y2;
+  n++;
 
-  if (x1 < 0 || x2 < 0)
+  if (x1 < view_lo_x || x2 < view_lo_x)
   {
-    sdl_drawline(x1 + kScreenWidth, y1, c1, x2 + kScreenWidth, y2, c2);
+    lines[n][0] = x1 + world_w;
+    lines[n][1] = y1;
+    lines[n][2] = x2 + world_w;
+    lines[n][3] = y2;
+    n++;
   }
-  else if (x1 >= kScreenWidth || x2 >= kScreenWidth)
+  else if (x1 >= view_lo_x + world_w || x2 >= view_lo_x + world_w)
   {
-    sdl_drawline(x1 - kScreenWidth, y1, c1, x2 - kScreenWidth, y2, c2);
+    lines[n][0] = x1 - world_w;
+    lines[n][1] = y1;
+    lines[n][2] = x2 - world_w;
+    lines[n][3] = y2;
+    n++;
   }
 
-  if (y1 < 0 || y2 < 0)
+  if (y1 < view_lo_y || y2 < view_lo_y)
   {
-    sdl_drawline(x1, y1 + kScreenHeight, c1, x2, y2 + kScreenHeight, c2);
+    lines[n][0] = x1;
+    lines[n][1] = y1 + world_h;
+    lines[n][2] = x2;
+    lines[n][3] = y2 + world_h;
+    n++;
   }
-  else if (y1 >= kScreenHeight || y2 >= kScreenHeight)
+  else if (y1 >= view_lo_y + world_h || y2 >= view_lo_y + world_h)
   {
-    sdl_drawline(x1, y1 - kScreenHeight, c1, x2, y2 - kScreenHeight, c2);
+    lines[n][0] = x1;
+    lines[n][1] = y1 - world_h;
+    lines[n][2] = x2;
+    lines[n][3] = y2 - world_h;
+    n++;
   }
+
+  return n;
 }
 
 /* Create a SDL_Color struct out of RGB values: */
@@ -1979,57 +3294,67 @@ mkcolor(int32_t r, int32_t g, int32_t b)
 
 void
 sdl_drawline(int32_t x1, int32_t y1, SDL_Color c1, int32_t x2, int32_t y2, SDL_Color c2)
+{
+  if (clip(&x1, &y1, &x2, &y2))
+  {
+    raster_line(x1, y1, c1, x2, y2, c2);
+  }
+}
+
+/* Draw a line that has already been clipped to the window: */
+
+void
+raster_line(int32_t x1, int32_t y1, SDL_Color c1, int32_t x2, int32_t y2, SDL_Color c2)
 {
   int32_t dx = 0, dy = 0;
-  double cr = NAN, cg = NAN, cb = NAN, rd = NAN, gd = NAN, bd = NAN;
+  int32_t cr = 0, cg = 0, cb = 0, rd = 0, gd = 0, bd = 0;
   double m = NAN, b = NAN;
 
-  if (clip(&x1, &y1, &x2, &y2))
+  dx = x2 - x1;
+  dy = y2 - y1;
+
+  if (dx != 0)
   {
-    dx = x2 - x1;
-    dy = y2 - y1;
+    m = ((double)dy) / ((double)dx);
+    b = y1 - m * x1;
 
-    if (dx != 0)
+    if (x2 >= x1)
+    {
+      dx = 1;
+    }
+    else
     {
-      m = ((double)dy) / ((double)dx);
-      b = y1 - m * x1;
+      dx = -1;
+    }
 
-      if (x2 >= x1)
-      {
-        dx = 1;
-      }
-      else
-      {
-        dx = -1;
-      }
+    /* Colors are stepped in 16.16 fixed point: */
 
-      cr = c1.r;
-      cg = c1.g;
-      cb = c1.b;
+    cr = c1.r << 16;
+    cg = c1.g << 16;
+    cb = c1.b << 16;
 
-      rd = (double)(c2.r - c1.r) / (double)(x2 - x1) * dx;
-      gd = (double)(c2.g - c1.g) / (double)(x2 - x1) * dx;
-      bd = (double)(c2.b - c1.b) / (double)(x2 - x1) * dx;
+    rd = ((c2.r - c1.r) * 65536) / (x2 - x1) * dx;
+    gd = ((c2.g - c1.g) * 65536) / (x2 - x1) * dx;
+    bd = ((c2.b - c1.b) * 65536) / (x2 - x1) * dx;
 
-      while (x1 != x2)
-      {
-        y1 = m * x1 + b;
-        y2 = m * (x1 + dx) + b;
+    while (x1 != x2)
+    {
+      y1 = m * x1 + b;
+      y2 = m * (x1 + dx) + b;
 
-        drawvertline(x1, y1, mkcolor(cr, cg, cb), y2, mkcolor(cr + rd, cg + gd, cb + bd));
+      drawvertline(x1, y1, mkcolor(cr >> 16, cg >> 16, cb >> 16), y2, mkcolor((cr + rd) >> 16, (cg + gd) >> 16, (cb + bd) >> 16));
 
-        x1 = x1 + dx;
+      x1 = x1 + dx;
 
-        cr = cr + rd;
-        cg = cg + gd;
-        cb = cb + bd;
-      }
-    }
-    else
-    {
-      drawvertline(x1, y1, c1, y2, c2);
+      cr = cr + rd;
+      cg = cg + gd;
+      cb = cb + bd;
     }
   }
+  else
+  {
+    drawvertline(x1, y1, c1, y2, c2);
+  }
 }
 
 /* Clip lines to window: */
@@ -2100,8 +3425,8 @@ clip(int32_t* x1, int32_t* y1, int32_t* x2, int32_t* y2)
       }
       else if (code1 & RIGHT_EDGE)
       {
-        fy1 += (((kScreenWidth - 1) - (fx1)) * m);
-        fx1 = (kScreenWidth - 1);
+        fy1 += (((screen_w - 1) - (fx1)) * m);
+        fx1 = (screen_w - 1);
       }
       else if (code1 & TOP_EDGE)
       {
@@ -2115,9 +3440,9 @@ clip(int32_t* x1, int32_t* y1, int32_t* x2, int32_t* y2)
       {
         if (fx2 != fx1)
         {
-          fx1 += (((kScreenHeight - 1) - (fy1)) / m);
+          fx1 += (((screen_h - 1) - (fy1)) / m);
         }
-        fy1 = (kScreenHeight - 1);
+        fy1 = (screen_h - 1);
       }
     }
   }
@@ -2154,7 +3479,7 @@ encode(double x, double y)
   {
     code = code | LEFT_EDGE;
   }
-  else if (x >= (double)kScreenWidth)
+  else if (x >= (double)screen_w)
   {
     code = code | RIGHT_EDGE;
   }
@@ -2163,7 +3488,7 @@ encode(double x, double y)
   {
     code = code | TOP_EDGE;
   }
-  else if (y >= (double)kScreenHeight)
+  else if (y >= (double)screen_h)
   {
     code = code | BOTTOM_EDGE;
   }
@@ -2177,7 +3502,7 @@ void
 drawvertline(int32_t x, int32_t y1, SDL_Color c1, int32_t y2, SDL_Color c2)
 {
   int32_t tmp = 0, dy = 0;
-  double cr = NAN, cg = NAN, cb = NAN, rd = NAN, gd = NAN, bd = NAN;
+  int32_t cr = 0, cg = 0, cb = 0, rd = 0, gd = 0, bd = 0;
 
   if (y1 > y2)
   {
@@ -2198,32 +3523,57 @@ drawvertline(int32_t x, int32_t y1, SDL_Color c1, int32_t y2, SDL_Color c2)
     c2.b = tmp;
   }
 
-  cr = c1.r;
-  cg = c1.g;
-  cb = c1.b;
+  /* Colors are stepped in 16.16 fixed point: */
+
+  cr = c1.r << 16;
+  cg = c1.g << 16;
+  cb = c1.b << 16;
 
   if (y1 != y2)
   {
-    rd = (double)(c2.r - c1.r) / (double)(y2 - y1);
-    gd = (double)(c2.g - c1.g) / (double)(y2 - y1);
-    bd = (double)(c2.b - c1.b) / (double)(y2 - y1);
+    rd = ((c2.r - c1.r) * 65536) / (y2 - y1);
+    gd = ((c2.g - c1.g) * 65536) / (y2 - y1);
+    bd = ((c2.b - c1.b) * 65536) / (y2 - y1);
   }
-  else
+
+  if (use_rgb565)
   {
-    rd = 0;
-    gd = 0;
-    bd = 0;
-  }
+    /* Write straight into the 16-bit frame, one column at a time: */
+
+    if (x < 0 || x >= screen_w)
+    {
+      return;
+    }
+
+    for (dy = y1; dy <= y2; dy++)
+    {
+      if (dy >= -1 && dy < screen_h - 1 && x + 1 < screen_w)
+      {
+        g_pixels[(dy + 1) * screen_w + x + 1] = 0;
+      }
+
+      if (dy >= 0 && dy < screen_h)
+      {
+        g_pixels[dy * screen_w + x] = (((cr >> 16) & 0xF8) << 8) | (((cg >> 16) & 0xFC) << 3) | ((cb >> 16) >> 3);
+      }
 
-  for (dy = y1; dy <= y2; dy++)
+      cr = cr + rd;
+      cg = cg + gd;
+      cb = cb + bd;
+    }
+  }
+  else
   {
-    putpixel(x + 1, dy + 1, (SDL_Color){.r = 0, .g = 0, .b = 0});
+    for (dy = y1; dy <= y2; dy++)
+    {
+      putpixel(x + 1, dy + 1, (SDL_Color){.r = 0, .g = 0, .b = 0});
 
-    putpixel(x, dy, (SDL_Color){.r = (uint8_t)cr, .g = (uint8_t)cg, .b = (uint8_t)cb});
+      putpixel(x, dy, (SDL_Color){.r = (uint8_t)(cr >> 16), .g = (uint8_t)(cg >> 16), .b = (uint8_t)(cb >> 16)});
 
-    cr = cr + rd;
-    cg = cg + gd;
-    cb = cb + bd;
+      cr = cr + rd;
+      cg = cg + gd;
+      cb = cb + bd;
+    }
   }
 }
 
@@ -2232,60 +3582,138 @@ drawvertline(int32_t x, int32_t y1, SDL_Color c1, int32_t y2, SDL_Color c2)
 void
 putpixel(int32_t x, int32_t y, SDL_Color color)
 {
-#if 0
-  int32_t bpp = 0;
-  uint8_t* p = 0;
-#endif
-
   /* Assuming the X/Y values are within the bounds of this surface... */
 
-  if (x >= 0 && y >= 0 && x < kScreenWidth && y < kScreenHeight)
+  if (x >= 0 && y >= 0 && x < screen_w && y < screen_h)
+  {
+    if (use_rgb565)
+    {
+      g_pixels[y * screen_w + x] = ((color.r & 0xF8) << 8) | ((color.g & 0xFC) << 3) | (color.b >> 3);
+    }
+    else
+    {
+      SDL_SetRenderDrawColor(g_renderer, color.r, color.g, color.b, 255);
+      SDL_RenderDrawPoint(g_renderer, x, y);
+    }
+  }
+}
+
+/* Erase the screen, optionally to the background image: */
+
+void
+screen_clear(bool background)
+{
+  if (use_rgb565)
+  {
+    if (background)
+    {
+      memcpy(g_pixels, g_background, screen_w * screen_h * sizeof(uint16_t));
+    }
+    else
+    {
+      memset(g_pixels, 0, screen_w * screen_h * sizeof(uint16_t));
+    }
+    return;
+  }
+
+  if (SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, 255))
   {
-    SDL_SetRenderDrawColor(g_renderer, color.r, color.g, color.b, 255);
-    SDL_RenderDrawPoint(g_renderer, x, y);
-#if 0
-      /* Determine bytes-per-pixel for the surface in question: */
+    fprintf(stderr, "SDL_SetRenderDrawControl: %s\n", SDL_GetError());
+    exit(EXIT_FAILURE);
+  }
+  if (SDL_RenderClear(g_renderer))
+  {
+    fprintf(stderr, "SDL_RenderClear: %s\n", SDL_GetError());
+    exit(EXIT_FAILURE);
+  }
 
-      bpp = surface->format->BytesPerPixel;
+  if (background)
+  {
+    SDL_RenderCopy(g_renderer, g_texture, NULL, NULL);
+  }
+}
 
-      /* Set a pointer to the exact location in memory of the pixel
-         in question: */
+/* Show the finished frame: */
 
-      p = (((uint8_t*)surface->pixels) + /* Start at beginning of RAM */
-           (y * surface->pitch) +        /* Go down Y lines */
-           (x * bpp));                   /* Go in X pixels */
+void
+screen_present(void)
+{
+  if (use_rgb565)
+  {
+    SDL_UpdateTexture(g_screen, NULL, g_pixels, screen_w * sizeof(uint16_t));
+    SDL_RenderCopy(g_renderer, g_screen, NULL, NULL);
+  }
 
-      /* Set the (correctly-sized) piece of data in the surface's RAM
-         to the pixel value sent in: */
+  SDL_RenderPresent(g_renderer);
+}
 
-      if (bpp == 1)
-        {
-          *p = pixel;
-        }
-      else if (bpp == 2)
-        {
-          *(uint16_t*)p = pixel;
-        }
-      else if (bpp == 3)
-        {
-          if (SDL_BYTEORDER == SDL_BIG_ENDIAN)
-            {
-              p[0] = (pixel >> 16) & 0xff;
-              p[1] = (pixel >> 8) & 0xff;
-              p[2] = pixel & 0xff;
-            }
-          else
-            {
-              p[0] = pixel & 0xff;
-              p[1] = (pixel >> 8) & 0xff;
-              p[2] = (pixel >> 16) & 0xff;
-            }
-        }
-      else if (bpp == 4)
+/* Load the background image, either as a texture or as a pre-converted
+   RGB565 buffer: */
+
+void
+load_background(void)
+{
+  bool loaded = false;
+
+  if (!use_rgb565)
+  {
+    g_texture = IMG_LoadTexture(g_renderer, DATA_PREFIX "images/redspot.jpg");
+    loaded = (g_texture != NULL);
+  }
+  else
+  {
+    g_screen = SDL_CreateTexture(g_renderer, SDL_PIXELFORMAT_RGB565, SDL_TEXTUREACCESS_STREAMING, screen_w, screen_h);
+    g_pixels = calloc(screen_w * screen_h, sizeof(uint16_t));
+    g_background = calloc(screen_w * screen_h, sizeof(uint16_t));
+
+    if (!g_screen || !g_pixels || !g_background)
+    {
+      fprintf(stderr,
+              "\nError: I could not create the RGB565 screen!\n"
+              "The Simple DirectMedia error that occured was:\n"
+              "%s\n\n",
+              SDL_GetError());
+      exit(1);
+    }
+
+    SDL_Surface* image = IMG_Load(DATA_PREFIX "images/redspot.jpg");
+    SDL_Surface* conv = 0;
+
+    if (image)
+    {
+      conv = SDL_ConvertSurfaceFormat(image, SDL_PIXELFORMAT_RGB565, 0);
+      SDL_FreeSurface(image);
+    }
+
+    if (conv)
+    {
+      /* Scale (nearest neighbour) to the screen, once, up front: */
+
+      SDL_LockSurface(conv);
+      for (int32_t y = 0; y < screen_h; y++)
+      {
+        const uint16_t* row = (const uint16_t*)((const uint8_t*)conv->pixels + (y * conv->h / screen_h) * conv->pitch);
+
+        for (int32_t x = 0; x < screen_w; x++)
         {
-          *(uint32_t*)p = pixel;
+          g_background[y * screen_w + x] = row[x * conv->w / screen_w];
         }
-#endif
+      }
+      SDL_UnlockSurface(conv);
+
+      SDL_FreeSurface(conv);
+      loaded = true;
+    }
+  }
+
+  if (!loaded)
+  {
+    fprintf(stderr,
+            "\nError: I could not open the background image:\n" DATA_PREFIX "images/redspot.jpg\n"
+            "The Simple DirectMedia error that occured was:\n"
+            "%s\n\n",
+            SDL_GetError());
+    exit(1);
   }
 }
 
@@ -2294,242 +3722,343 @@ putpixel(int32_t x, int32_t y, SDL_Color color)
 void
 draw_segment(int32_t r1, int32_t a1, SDL_Color c1, int32_t r2, int32_t a2, SDL_Color c2, int32_t cx, int32_t cy, int32_t a)
 {
-  draw_line(((fast_cos((a1 + a) >> 3) * r1) >> 10) + cx,
-            cy - ((fast_sin((a1 + a) >> 3) * r1) >> 10),
+  draw_line(((trig_cos(trig_deg(a1 + a)) * r1) >> kTrigShift) + cx,
+            cy - ((trig_sin(trig_deg(a1 + a)) * r1) >> kTrigShift),
             c1,
-            ((fast_cos((a2 + a) >> 3) * r2) >> 10) + cx,
-            cy - ((fast_sin((a2 + a) >> 3) * r2) >> 10),
+            ((trig_cos(trig_deg(a2 + a)) * r2) >> kTrigShift) + cx,
+            cy - ((trig_sin(trig_deg(a2 + a)) * r2) >> kTrigShift),
             c2);
 }
 
-/* Add a bullet: */
+/* Copy just the live particles: */
 
 void
-add_bullet(int32_t x, int32_t y, int32_t a, int32_t xm, int32_t ym)
+particles_copy(Particles* dst, const Particles* src)
 {
-  int32_t found = 0;
+  size_t n = src->count * sizeof(int32_t);
+
+  dst->count = src->count;
+  memcpy(dst->life, src->life, n);
+  memcpy(dst->x, src->x, n);
+  memcpy(dst->y, src->y, n);
+  memcpy(dst->xm, src->xm, n);
+  memcpy(dst->ym, src->ym, n);
+}
+
+/* Draw each particle as a short white streak along its motion.  They
+   travel in straight lines, so they are placed by stepping back from the
+   latest state rather than blending with the previous one: */
 
-  found = -1;
+void
+particles_draw(const Particles* p, int32_t alpha, int32_t cam_x, int32_t cam_y)
+{
+  const int32_t w = world_w * kFixOne, h = world_h * kFixOne;
 
-  for (size_t i = 0; i < kNumBullets && found == -1; i++)
+  for (size_t i = 0; i < p->count; i++)
   {
-    if (bullets[i].timer <= 0)
+    int32_t fx = p->x[i] - (p->xm[i] * (256 - alpha)) / 256;
+    int32_t fy = p->y[i] - (p->ym[i] * (256 - alpha)) / 256;
+
+    fx += -(fx < 0) & w;
+    fx -= -(fx >= w) & w;
+    fy += -(fy < 0) & h;
+    fy -= -(fy >= h) & h;
+
+    int32_t x = view_wrap((fx >> kFixShift) - cam_x, view_lo_x, world_w);
+    int32_t y = view_wrap((fy >> kFixShift) - cam_y, view_lo_y, world_h);
+    int32_t dx = p->xm[i] / kFixOne, dy = p->ym[i] / kFixOne;
+    int32_t len = abs(dx) > abs(dy) ? abs(dx) : abs(dy);
+
+    if (x + len < 0 || x - len >= screen_w || y + len < 0 || y - len >= screen_h)
     {
-      found = i;
+      continue;
     }
-  }
 
-  if (found != -1)
-  {
-    bullets[found].timer = 50;
+    if (len == 0)
+    {
+      particles_plot(x, y);
+      continue;
+    }
 
-    bullets[found].x = x;
-    bullets[found].y = y;
+    /* Step along the streak in 16.16 fixed point: */
 
-    bullets[found].xm = ((fast_cos(a >> 3) * 5) >> 10) + (xm >> 4);
-    bullets[found].ym = -((fast_sin(a >> 3) * 5) >> 10) + (ym >> 4);
+    int32_t sx = (dx * 65536) / len, sy = (dy * 65536) / len;
+    int32_t cx = x * 65536 + 32768, cy = y * 65536 + 32768;
 
-    playsound(SND_BULLET);
+    for (int32_t k = 0; k <= len; k++)
+    {
+      particles_plot(cx >> 16, cy >> 16);
+      cx += sx;
+      cy += sy;
+    }
   }
+
+  particles_flush();
 }
 
-/* Add an asteroid: */
+/* Queue one point of a streak, wrapped around the world, if it is in
+   view: */
 
 void
-add_asteroid(int32_t x, int32_t y, int32_t xm, int32_t ym, int32_t size)
+particles_plot(int32_t x, int32_t y)
 {
-  int32_t found = 0;
+  x = view_wrap(x, view_lo_x, world_w);
+  y = view_wrap(y, view_lo_y, world_h);
 
-  /* Find a slot: */
+  if ((uint32_t)x >= (uint32_t)screen_w || (uint32_t)y >= (uint32_t)screen_h)
+  {
+    return;
+  }
 
-  found = -1;
+  particle_points[0][particle_batch] = (SDL_Point){.x = x + 1, .y = y + 1};
+  particle_points[1][particle_batch] = (SDL_Point){.x = x, .y = y};
 
-  for (size_t i = 0; i < kNumAsteroids && found == -1; i++)
+  if (++particle_batch == kParticleBatch)
   {
-    if (asteroids[i].alive == 0)
-    {
-      found = i;
-    }
+    particles_flush();
   }
+}
 
-  /* Hack: No asteroids should be stationary! */
+/* Draw the queued points: all the shadows first, then the streaks: */
 
-  while (xm == 0)
+void
+particles_flush(void)
+{
+  if (!particle_batch)
   {
-    xm = (random_get() % 3) - 1;
+    return;
   }
 
-  if (found != -1)
+  if (use_rgb565)
   {
-    asteroids[found].alive = 1;
-
-    asteroids[found].x = x;
-    asteroids[found].y = y;
-    asteroids[found].xm = xm;
-    asteroids[found].ym = ym;
-
-    asteroids[found].angle = (random_get() % 360);
-    asteroids[found].angle_m = (random_get() % 6) - 3;
+    for (size_t i = 0; i < particle_batch; i++)
+    {
+      const SDL_Point* pt = &particle_points[0][i];
 
-    asteroids[found].size = size;
+      if (pt->x < screen_w && pt->y < screen_h)
+      {
+        g_pixels[pt->y * screen_w + pt->x] = 0;
+      }
+    }
 
-    for (size_t i = 0; i < kAsteroidsSides; i++)
+    for (size_t i = 0; i < particle_batch; i++)
     {
-      asteroids[found].shape[i].radius = (random_get() % 3);
-      asteroids[found].shape[i].angle = i * 60 + (random_get() % 40);
+      const SDL_Point* pt = &particle_points[1][i];
+
+      g_pixels[pt->y * screen_w + pt->x] = 0xFFFF;
     }
   }
+  else
+  {
+    SDL_SetRenderDrawColor(g_renderer, 0, 0, 0, 255);
+    SDL_RenderDrawPoints(g_renderer, particle_points[0], (int)particle_batch);
+    SDL_SetRenderDrawColor(g_renderer, 255, 255, 255, 255);
+    SDL_RenderDrawPoints(g_renderer, particle_points[1], (int)particle_batch);
+  }
+
+  particle_batch = 0;
 }
 
-/* Add a bit: */
+/* Draw an asteroid: */
 
 void
-add_bit(int32_t x, int32_t y, int32_t xm, int32_t ym)
+draw_asteroid(int32_t size, int32_t x, int32_t y, int32_t angle, const Shape* shape, AsteroidCache* cache)
 {
-  int32_t found = 0;
+  int32_t quant[kAsteroidsSides] = {0};
+  SDL_Color colors[kAsteroidsSides] = {0};
+  bool hit = false;
 
-  found = -1;
+  hit = (cache->valid && cache->x == x && cache->y == y && cache->size == size && !memcmp(cache->shape, shape, sizeof(cache->shape)));
 
-  for (size_t i = 0; i < kNumBits && found == -1; i++)
+  for (size_t i = 0; i < kAsteroidsSides; i++)
   {
-    if (bits[i].timer <= 0)
+    int32_t b = (((shape[i].angle + angle) % 180) * 255) / 240;
+
+    colors[i] = mkcolor(b, b, b);
+    quant[i] = trig_deg(shape[i].angle + angle);
+
+    if (cache->angle[i] != quant[i])
     {
-      found = i;
+      hit = false;
     }
   }
 
-  if (found != -1)
+  /* Only transform and clip the outline again if it actually changed: */
+
+  if (!hit)
   {
-    bits[found].timer = 16;
+    int32_t s[kAsteroidsSides] = {0}, c[kAsteroidsSides] = {0};
 
-    bits[found].x = x;
-    bits[found].y = y;
-    bits[found].xm = xm;
-    bits[found].ym = ym;
-  }
-}
+    trig_sincos(quant, s, c, kAsteroidsSides);
 
-/* Draw an asteroid: */
+    cache->valid = true;
+    cache->x = x;
+    cache->y = y;
+    cache->size = size;
+    memcpy(cache->shape, shape, sizeof(cache->shape));
+    cache->num_segments = 0;
 
-void
-draw_asteroid(int32_t size, int32_t x, int32_t y, int32_t angle, Shape* shape)
-{
-  int32_t b1 = 0, b2 = 0;
-  int32_t div = 0;
+    for (size_t i = 0; i < kAsteroidsSides; i++)
+    {
+      size_t j = (i + 1) % kAsteroidsSides;
+      int32_t r1 = size * (kAsteroidsRadius - shape[i].radius);
+      int32_t r2 = size * (kAsteroidsRadius - shape[j].radius);
+      int32_t lines[3][4] = {0};
 
-  div = 240;
+      cache->angle[i] = quant[i];
 
-  for (size_t i = 0; i < kAsteroidsSides - 1; i++)
-  {
-    b1 = (((shape[i].angle + angle) % 180) * 255) / div;
-    b2 = (((shape[i + 1].angle + angle) % 180) * 255) / div;
+      size_t n = wrap_line(((c[i] * r1) >> kTrigShift) + x,
+                           y - ((s[i] * r1) >> kTrigShift),
+                           ((c[j] * r2) >> kTrigShift) + x,
+                           y - ((s[j] * r2) >> kTrigShift),
+                           lines);
 
-    draw_segment((size * (kAsteroidsRadius - shape[i].radius)),
-                 shape[i].angle,
-                 mkcolor(b1, b1, b1),
-                 (size * (kAsteroidsRadius - shape[i + 1].radius)),
-                 shape[i + 1].angle,
-                 mkcolor(b2, b2, b2),
-                 x,
-                 y,
-                 angle);
+      for (size_t k = 0; k < n; k++)
+      {
+        if (clip(&lines[k][0], &lines[k][1], &lines[k][2], &lines[k][3]))
+        {
+          Segment* seg = &cache->segments[cache->num_segments++];
+
+          seg->x1 = lines[k][0];
+          seg->y1 = lines[k][1];
+          seg->x2 = lines[k][2];
+          seg->y2 = lines[k][3];
+          seg->edge = i;
+        }
+      }
+    }
   }
 
-  b1 = (((shape[kAsteroidsSides - 1].angle + angle) % 180) * 255) / div;
-  b2 = (((shape[0].angle + angle) % 180) * 255) / div;
+  /* Colors follow the exact angle, so they are picked fresh each frame: */
 
-  draw_segment((size * (kAsteroidsRadius - shape[kAsteroidsSides - 1].radius)),
-               shape[kAsteroidsSides - 1].angle,
-               mkcolor(b1, b1, b1),
-               (size * (kAsteroidsRadius - shape[0].radius)),
-               shape[0].angle,
-               mkcolor(b2, b2, b2),
-               x,
-               y,
-               angle);
+  for (size_t i = 0; i < cache->num_segments; i++)
+  {
+    Segment* seg = &cache->segments[i];
+
+    raster_line(seg->x1,
+                seg->y1,
+                colors[seg->edge],
+                seg->x2,
+                seg->y2,
+                colors[(seg->edge + 1) % kAsteroidsSides]);
+  }
 }
 
-/* Queue a sound! */
+/* How bounce mode's cost grows with the number of rocks, in a world as big
+   as it gets: */
 
 void
-playsound(int32_t snd)
+rocks_bench(void)
 {
-  if (use_sound)
+  static const size_t counts[] = {1000, 2000, 5000, 10000};
+  const size_t steps = 240;
+  double freq = (double)SDL_GetPerformanceFrequency();
+
+  max_asteroids = counts[sizeof(counts) / sizeof(counts[0]) - 1];
+  world_scale = kMaxWorld;
+  world_setup();
+  arena_setup();
+
+  printf("Bounce mode, %dx%d world, %zu steps:\n", world_w, world_h, steps);
+
+  for (size_t c = 0; c < sizeof(counts) / sizeof(counts[0]); c++)
   {
-    assert(snd >= 0 && snd < NUM_SOUNDS);
+    size_t bounces = 0;
+    Uint64 ticks = 0;
 
-    int32_t which = (random_get() % 3) + CHAN_THRUST;
-    for (size_t i = CHAN_THRUST; i < 4; i++)
+    rocks_clear();
+
+    for (size_t i = 0; i < counts[c]; i++)
     {
-      if (!Mix_Playing(i))
-      {
-        which = i;
-      }
+      add_asteroid(random_range(world_w) * kFixOne,
+                   random_range(world_h) * kFixOne,
+                   (random_range(9) - 4) * (kFixOne / kAsteroidsStep),
+                   (random_range(9) - 4) * (kFixOne / kAsteroidsStep),
+                   random_range(2) + 1);
     }
 
-    Mix_PlayChannel(which, sounds[snd], 0);
+    for (size_t st = 0; st < steps; st++)
+    {
+      move_bodies(asteroids.x, asteroids.y, asteroids.xm, asteroids.ym, asteroid_pool.used);
+
+      Uint64 t0 = SDL_GetPerformanceCounter();
+      bounces += rocks_bounce();
+      ticks += SDL_GetPerformanceCounter() - t0;
+    }
+
+    printf("%6zu rocks: %7.3f ms/step, %9.0f pairs tested (of %10.0f), %6.1f bounces\n",
+           counts[c],
+           ticks * 1e3 / freq / steps,
+           (double)sap_tests / steps,
+           (double)counts[c] * (counts[c] - 1) / 2,
+           (double)bounces / steps);
   }
 }
 
-/* Break an asteroid and add an explosion: */
+/* Play the sounds the last step called for, and keep the thruster going
+   while it is held (the explosion stops it): */
 
 void
-hurt_asteroid(int32_t j, int32_t xm, int32_t ym, size_t exp_size)
+sounds_play(const Input* input)
 {
-  add_score(100 / (asteroids[j].size + 1));
-
-  if (asteroids[j].size > 1)
-  {
-    /* Break the rock into two smaller ones! */
+  uint32_t due = sounds_due;
 
-    add_asteroid(asteroids[j].x,
-                 asteroids[j].y,
-                 ((asteroids[j].xm + xm) / 2),
-                 (asteroids[j].ym + ym),
-                 asteroids[j].size - 1);
+  sounds_due = 0;
 
-    add_asteroid(asteroids[j].x,
-                 asteroids[j].y,
-                 (asteroids[j].xm + xm),
-                 ((asteroids[j].ym + ym) / 2),
-                 asteroids[j].size - 1);
+  if (!use_sound)
+  {
+    return;
   }
 
-  /* Make the original go away: */
-
-  asteroids[j].alive = 0;
+  if (input->up && player_alive)
+  {
+    if (!Mix_Playing(CHAN_THRUST))
+    {
+      Mix_PlayChannel(CHAN_THRUST, sounds[SND_THRUST], -1);
+    }
+  }
+  else if (Mix_Playing(CHAN_THRUST))
+  {
+    Mix_HaltChannel(CHAN_THRUST);
+  }
 
-  /* Add explosion: */
+  for (int32_t snd = 0; snd < NUM_SOUNDS; snd++)
+  {
+    if (due & (1u << snd))
+    {
+      playsound(snd);
+    }
+  }
 
-  playsound(SND_AST1 + (asteroids[j].size) - 1);
+  /* (Game over is played on three channels at once:) */
 
-  for (size_t k = 0; k < exp_size; k++)
+  if (due & (1u << SND_GAMEOVER))
   {
-    add_bit((asteroids[j].x - (asteroids[j].size * kAsteroidsRadius) + (random_get() % (kAsteroidsRadius * 2))),
-            (asteroids[j].y - (asteroids[j].size * kAsteroidsRadius) + (random_get() % (kAsteroidsRadius * 2))),
-            ((random_get() % (asteroids[j].size * 3)) - (asteroids[j].size) + ((xm + asteroids[j].xm) / 3)),
-            ((random_get() % (asteroids[j].size * 3)) - (asteroids[j].size) + ((ym + asteroids[j].ym) / 3)));
+    playsound(SND_GAMEOVER);
+    playsound(SND_GAMEOVER);
   }
 }
 
-/* Increment score: */
+/* Queue a sound! */
 
 void
-add_score(int32_t amount)
+playsound(int32_t snd)
 {
-  /* See if they deserve a new life: */
-
-  if (score / kOneUpScore < (score + amount) / kOneUpScore)
+  if (use_sound)
   {
-    lives++;
-    strcpy(zoom_str, "EXTRA LIFE");
-    text_zoom = kZoomStart;
-    playsound(SND_EXTRALIFE);
-  }
+    assert(snd >= 0 && snd < NUM_SOUNDS);
 
-  /* Add to score: */
+    int32_t which = random_effect(3) + CHAN_THRUST;
+    for (size_t i = CHAN_THRUST; i < 4; i++)
+    {
+      if (!Mix_Playing(i))
+      {
+        which = i;
+      }
+    }
 
-  score = score + amount;
+    Mix_PlayChannel(which, sounds[snd], 0);
+  }
 }
 
 /* Draw a character: */
@@ -2584,36 +4113,68 @@ draw_thick_line(int32_t x1, int32_t y1, SDL_Color c1, int32_t x2, int32_t y2, SD
   draw_line(x1 + 1, y1 + 1, c1, x2 + 1, y2 + 1, c2);
 }
 
+/* Add a latency sample: */
+
 void
-reset_level(void)
+histogram_add(Histogram* h, Uint32 ms)
 {
-  for (size_t i = 0; i < kNumBullets; i++)
-  {
-    bullets[i].timer = 0;
-  }
+  h->count[ms < kLatencyBins ? ms : kLatencyBins - 1]++;
+  h->total++;
+  h->sum += ms;
 
-  for (size_t i = 0; i < kNumAsteroids; i++)
+  if (ms > h->max)
   {
-    asteroids[i].alive = 0;
+    h->max = ms;
   }
+}
+
+/* Show a latency histogram, with a few percentiles: */
 
-  for (size_t i = 0; i < kNumBits; i++)
+void
+histogram_print(FILE* f, const char* name, const Histogram* h)
+{
+  fprintf(f, "%s latency: %zu samples", name, h->total);
+
+  if (!h->total)
   {
-    bits[i].timer = 0;
+    fprintf(f, "\n");
+    return;
   }
 
-  for (size_t i = 0; i < (level + 1) && i < 10; i++)
+  size_t p50 = 0, p95 = 0, p99 = 0, seen = 0;
+
+  for (size_t i = 0; i < kLatencyBins; i++)
   {
-    add_asteroid(/* x */ (random_get() % 40) + ((kScreenWidth - 40) * (random_get() % 2)),
-                 /* y */ (random_get() % kScreenHeight),
-                 /* xm */ (random_get() % 9) - 4,
-                 /* ym */ ((random_get() % 9) - 4) * 4,
-                 /* size */ (random_get() % 3) + 2);
+    seen += h->count[i];
+
+    if (!p50 && seen * 100 >= h->total * 50)
+    {
+      p50 = i + 1;
+    }
+    if (!p95 && seen * 100 >= h->total * 95)
+    {
+      p95 = i + 1;
+    }
+    if (!p99 && seen * 100 >= h->total * 99)
+    {
+      p99 = i + 1;
+    }
   }
 
-  sprintf(zoom_str, "LEVEL %ld", level);
+  fprintf(f, ", mean %.1f ms, p50 %zu ms, p95 %zu ms, p99 %zu ms, max %u ms\n",
+          (double)h->sum / (double)h->total,
+          p50 - 1,
+          p95 - 1,
+          p99 - 1,
+          h->max);
 
-  text_zoom = kZoomStart;
+  for (size_t i = 0; i < kLatencyBins; i++)
+  {
+    if (h->count[i])
+    {
+      fprintf(f, "  %2zu%s ms: %zu\n", i, i == kLatencyBins - 1 ? "+" : " ", h->count[i]);
+    }
+  }
 }
 
 /* Show program version: */
@@ -2629,8 +4190,15 @@ show_version(void)
 void
 show_usage(FILE* f, const char* prg)
 {
-  fprintf(f, "Usage: %s {--help | --usage | --version | --copying }\n"
-             "       %s [--fullscreen] [--nosound]\n\n",
+  fprintf(f, "Usage: %s {--help | --usage | --version | --copying |\n"
+             "           --bench-trig | --bench-rocks}\n"
+             "       %s [--fullscreen] [--nosound] [--rgb565] [--threaded]\n"
+             "          [--sync {vsync | limit | off}] [--latency] [--late-input]\n"
+             "          [--realtime [--cpu N]] [--config FILE]\n"
+             "          [--bullets N] [--asteroids N] [--particles N] [--stress N]\n"
+             "          [--jobs N] [--world N] [--size WxH] [--bounce] [--seed N]\n"
+             "       %s --headless [--frames N] [--seed N] [--config FILE] ...\n\n",
+          prg,
           prg,
           prg);
 }
@@ -2640,5 +4208,5 @@ show_usage(FILE* f, const char* prg)
 void
 draw_centered_text(char* str, int32_t y, int32_t s, SDL_Color c)
 {
-  draw_text(str, (kScreenWidth - strlen(str) * (s + 3)) / 2, y, s, c);
+  draw_text(str, (screen_w - strlen(str) * (s + 3)) / 2, y, s, c);
 }
@@ -0,0 +1,3148 @@
+/*
+  vectoroids_core.c
+
+  The Vectoroids simulation, with no SDL in it (see vectoroids_core.h).
+  Built on its own as libvectoroids_core, which the game links.
+
+  by Bill Kendrick
+  bill@newbreedsoftware.com
+  http://www.newbreedsoftware.com/vectoroids/
+
+  SDL2 port by Marc-Alexandre Espiaut, for Logicoq
+  malespiaut.dev@posteo.eu
+  http://logicoq.free.fr
+*/
+
+#include <assert.h>
+#include <errno.h>
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#include "vectoroids_core_internal.h"
+
+/* Constraints (the core's own; see the headers for the rest): */
+
+#define kNumBits 50
+#define kNumParticles 131072
+#define kMaxCapacity (1 << 22)
+#define kParticleLife 16
+#define kRandomBatch 64
+#define kExplosionScale 8
+#define kJobGrain 4096
+#define kJobQueryGrain 64
+#define kSweepBatch 16
+#define kGymGrain 64
+
+#define kAsteroidsMaxSpeed 16
+#define kBulletSpeed 5
+#define kBulletRadius 5
+
+#define kOneUpScore 10000
+
+#define kScreenWidth 480
+#define kScreenHeight 480
+#define kScreenMin 240
+#define kScreenMax 4096
+
+/* Types: */
+
+/* A burst of particles, spread over a square of 'radius' around (x, y),
+   with up to 'speed' added to the drift (xm, ym) in each direction: */
+
+typedef struct Emitter Emitter;
+struct Emitter
+{
+  int32_t x;
+  int32_t y;
+  int32_t radius;
+  int32_t xm;
+  int32_t ym;
+  int32_t speed;
+  int32_t life;
+  size_t count;
+};
+
+/* A saved game, for gym_clone() and gym_restore(): the scalars, then a
+   copy of the arena's game state tables (arena.state bytes): */
+
+struct GymState
+{
+  int32_t player_x;
+  int32_t player_y;
+  int32_t player_xm;
+  int32_t player_ym;
+  int32_t player_angle;
+  int32_t player_alive;
+  int32_t player_die_timer;
+  size_t lives;
+  size_t score;
+  size_t level;
+  size_t sim_counter;
+  size_t sap_count;
+  int32_t grid_max_size;
+  int32_t text_zoom;
+  uint64_t rng[4];
+  Pool bullet_pool;
+  Pool asteroid_pool;
+  uint8_t tables[];
+};
+
+/* Many games played side by side by gym_batch_step(), apart from the one
+   in the globals, all in an arena of their own.  Each game's scalars are
+   arrays across the games, and the tables are laid out [slot][game] (slot
+   's' of game 'g' is at s * count + g), so things are moved, and bullets
+   tested against rocks, across the games at once.  Only what plays the
+   game is kept: no debris, and no outlines or spin: */
+
+struct GymBatch
+{
+  size_t count;
+  Arena arena;
+  int32_t* player_x;
+  int32_t* player_y;
+  int32_t* player_xm;
+  int32_t* player_ym;
+  int32_t* player_angle;
+  int32_t* player_alive;
+  int32_t* player_die_timer;
+  int32_t* text_zoom;
+  size_t* lives;
+  size_t* score;
+  size_t* level;
+  size_t* sim_counter;
+  uint64_t (*rng)[4];
+  Pool* bullet_pool;
+  Pool* asteroid_pool;
+  Bullets bullets;
+  Asteroids asteroids;
+  int32_t* bullet_hits;
+};
+
+/* What gym_batch_step() hands each run of games it splits the batch into: */
+
+typedef struct GymBatchStep GymBatchStep;
+struct GymBatchStep
+{
+  GymBatch* batch;
+  const uint32_t* actions;
+  int32_t* rewards;
+  bool* dones;
+  GymObs* obs;
+};
+
+/* The core's own helpers: */
+
+static void tables_alloc(void);
+static void pool_setup(Pool* pool, size_t capacity);
+static void pool_clear(Pool* pool);
+static int32_t pool_alloc(Pool* pool);
+static void pool_free(Pool* pool, int32_t slot);
+static void particles_emit(const Emitter* e);
+static void particles_step(void);
+static void particles_step_job(void* data, size_t begin, size_t end);
+static void add_bullet(int32_t x, int32_t y, int32_t a, int32_t xm, int32_t ym);
+static void hurt_asteroid(int32_t j, int32_t xm, int32_t ym, size_t exp_size);
+static void add_score(int32_t amount);
+static void events_emit(const Event* e);
+static void events_process(void);
+static void grid_clear(void);
+static void grid_insert(int32_t i);
+static void grid_remove(int32_t i);
+static void grid_update(int32_t i);
+static size_t grid_query(int32_t x, int32_t y, int32_t r, int32_t* out);
+static int32_t grid_first_sweep(size_t i, int32_t r);
+static bool bullet_sweeps(size_t i, int32_t j, int32_t r);
+static bool rocks_touch(int32_t a, int32_t b);
+static void reset_level(void);
+static void random_spread(uint64_t s[4], uint64_t seed);
+static void random_jump(uint64_t s[4]);
+static size_t jobs_chunk(size_t n, size_t grain);
+static void bullets_hit_job(void* data, size_t begin, size_t end);
+static void asteroids_move_job(void* data, size_t begin, size_t end);
+static void move_bodies_480x480(int32_t* restrict x, int32_t* restrict y, const int32_t* restrict xm, const int32_t* restrict ym, size_t n);
+static void move_bodies_640x480(int32_t* restrict x, int32_t* restrict y, const int32_t* restrict xm, const int32_t* restrict ym, size_t n);
+static void move_bodies_pow2(int32_t* restrict x, int32_t* restrict y, const int32_t* restrict xm, const int32_t* restrict ym, size_t n);
+static void move_bodies_any(int32_t* restrict x, int32_t* restrict y, const int32_t* restrict xm, const int32_t* restrict ym, size_t n);
+static void gym_batch_tables(GymBatch* b);
+static void gym_batch_pools(Pool* pools, size_t n, size_t capacity);
+static void gym_batch_job(void* data, size_t begin, size_t end);
+static bool gym_batch_control(GymBatch* b, size_t g, uint32_t actions);
+static bool gym_batch_crowded(const GymBatch* b, size_t g);
+static void gym_batch_bullet(GymBatch* b, size_t g);
+static void gym_batch_hits(GymBatch* b, size_t begin, size_t end);
+static int32_t gym_batch_first(const GymBatch* b, size_t g, size_t i);
+static bool gym_batch_sweeps(const GymBatch* b, size_t g, size_t i, int32_t j);
+static void gym_batch_shots(GymBatch* b, size_t g, int32_t* reward);
+static void gym_batch_finish(GymBatch* b, size_t g, int32_t* reward);
+static void gym_batch_rock(GymBatch* b, size_t g, int32_t x, int32_t y, int32_t xm, int32_t ym, int32_t size);
+static void gym_batch_hurt(GymBatch* b, size_t g, int32_t j, int32_t xm, int32_t ym, int32_t* reward);
+static void gym_batch_score(GymBatch* b, size_t g, int32_t amount, int32_t* reward);
+static void gym_batch_level(GymBatch* b, size_t g);
+static void gym_batch_reset(GymBatch* b, size_t g);
+static void gym_batch_observe(const GymBatch* b, size_t g, GymObs* obs);
+
+/* Game state: */
+
+Bullets bullets = {0};
+Asteroids asteroids = {0};
+Shape (*shapes)[kAsteroidsSides] = 0;
+Pool bullet_pool = {0};
+Pool asteroid_pool = {0};
+Particles particles = {0};
+size_t particles_dropped = 0;
+int32_t player_x = 0, player_y = 0, player_xm = 0, player_ym = 0, player_angle = 0;
+int32_t player_alive = 0, player_die_timer = 0;
+size_t lives = 0, score = 0, level = 0;
+int32_t text_zoom = 0;
+char zoom_str[24] = {0};
+size_t sim_counter = 0;
+uint32_t sounds_due = 0;
+
+/* Entity capacities (from the config file and command line), and the one
+   block of memory every table is carved out of at startup: */
+
+size_t max_bullets = kNumBullets;
+size_t max_asteroids = kNumAsteroids;
+size_t max_particles = kNumParticles;
+size_t stress_rocks = 0;
+size_t job_workers = 0;
+Arena arena = {0};
+
+/* The (wrapping) world is 'world_scale' screens across and down: */
+
+int32_t screen_w = kScreenWidth;
+int32_t screen_h = kScreenHeight;
+size_t world_scale = 1;
+int32_t world_w = kScreenWidth;
+int32_t world_h = kScreenHeight;
+
+/* Uniform grid over the world; each live asteroid sits in the cell holding
+   its center, on a doubly-linked list: */
+
+int32_t grid_cols = kScreenWidth / kGridCell;
+int32_t grid_rows = kScreenHeight / kGridCell;
+int32_t* grid_head = 0;
+int32_t* grid_next = 0;
+static int32_t* grid_prev = 0;
+static int32_t* grid_cell = 0;
+static int32_t* grid_found = 0;
+static int32_t grid_max_size = 0;
+
+/* In bounce mode, rocks bounce off each other.  Live rocks are kept in
+   order of their left edges (sweep and prune), and that order carries
+   over from step to step; their heights and sizes are copied alongside,
+   so the sweep reads straight through memory: */
+
+bool bounce_rocks = false;
+static int32_t* sap_order = 0;
+static int32_t* sap_left = 0;
+static int32_t* sap_y = 0;
+static int32_t* sap_r = 0;
+static uint8_t* sap_listed = 0;
+static size_t sap_count = 0;
+size_t sap_tests = 0;
+
+static int32_t* bullet_hits = 0;
+static size_t job_counts[kJobChunks] = {0};
+
+/* The event ring (a power of two long, and room for everything one step
+   can post; 'events_head', 'events_done' and 'events_tail' only ever
+   count up, and the ring is only emptied as each step starts, so the last
+   step's events stay readable after it): */
+
+static Event* events = 0;
+static size_t events_mask = 0;
+static size_t events_head = 0;
+static size_t events_done = 0;
+static size_t events_tail = 0;
+size_t events_dropped = 0;
+
+/* Hooks (see vectoroids_core_internal.h): */
+
+void (*jobs_run)(JobFn fn, void* data, size_t n, size_t size) = jobs_serial;
+void (*tables_extra)(void) = 0;
+
+/* Sine table: kTrigSize steps per turn, plus a quarter turn more so
+   cosine can read it at an offset without a second mask.  The compiler
+   fills it in: a Taylor series evaluated on the first quadrant, mirrored
+   into the other three and rounded to Q1.14. */
+
+#define TRIG_Q(i) ((((i) >> 10) & 1) ? 1024 - ((i) & 1023) : ((i) & 1023))
+#define TRIG_X(i) (TRIG_Q(i) * (3.14159265358979323846 / 2048.0))
+#define TRIG_T(x) ((x) * (1.0 - (x) * (x) / 6.0 * (1.0 - (x) * (x) / 20.0 * (1.0 - (x) * (x) / 42.0 * (1.0 - (x) * (x) / 72.0 * (1.0 - (x) * (x) / 110.0))))))
+#define TRIG_E(i) ((int16_t)((((i) >> 11) & 1 ? -1.0 : 1.0) * (TRIG_T(TRIG_X(i)) * kTrigOne + 0.5)))
+#define TRIG_16(p) TRIG_E(p##0), TRIG_E(p##1), TRIG_E(p##2), TRIG_E(p##3), TRIG_E(p##4), TRIG_E(p##5), TRIG_E(p##6), TRIG_E(p##7), \
+                   TRIG_E(p##8), TRIG_E(p##9), TRIG_E(p##A), TRIG_E(p##B), TRIG_E(p##C), TRIG_E(p##D), TRIG_E(p##E), TRIG_E(p##F)
+#define TRIG_256(p) TRIG_16(p##0), TRIG_16(p##1), TRIG_16(p##2), TRIG_16(p##3), TRIG_16(p##4), TRIG_16(p##5), TRIG_16(p##6), TRIG_16(p##7), \
+                    TRIG_16(p##8), TRIG_16(p##9), TRIG_16(p##A), TRIG_16(p##B), TRIG_16(p##C), TRIG_16(p##D), TRIG_16(p##E), TRIG_16(p##F)
+
+static_assert(kTrigSize == 4096, "sin_table is laid out for 4096 steps per turn");
+
+const int16_t sin_table[kTrigSize + kTrigSize / 4] = {
+  TRIG_256(0x0), TRIG_256(0x1), TRIG_256(0x2), TRIG_256(0x3), TRIG_256(0x4), TRIG_256(0x5), TRIG_256(0x6), TRIG_256(0x7),
+  TRIG_256(0x8), TRIG_256(0x9), TRIG_256(0xA), TRIG_256(0xB), TRIG_256(0xC), TRIG_256(0xD), TRIG_256(0xE), TRIG_256(0xF),
+  TRIG_256(0x10), TRIG_256(0x11), TRIG_256(0x12), TRIG_256(0x13)};
+
+/* Moves every moving thing; world_setup() picks the version made for the
+   world's size: */
+
+void (*move_bodies)(int32_t* restrict x, int32_t* restrict y, const int32_t* restrict xm, const int32_t* restrict ym, size_t n) = move_bodies_any;
+
+/* PRNG - xoshiro256++, one stream per kind of use.  Gameplay draws only
+   from RNG_GAME, so effects and rendering can never change how a game
+   plays out; random_setup() places the other streams 2^128 draws further
+   along with random_jump(), so no two of them can overlap: */
+
+uint64_t rngstate[NUM_RNG][4] = {{0xdeadbeef, 0x8badf00d, 0xbaaaaaad, 0xfeedc0de}};
+
+/* Size the world and lay out its tables, for the capacities configured so
+   far (a game still has to be started, with game_reset()): */
+
+void
+core_init(void)
+{
+  world_setup();
+  arena_setup();
+}
+
+/* Point 'st' at the game as it stands: */
+
+void
+core_state(CoreState* st)
+{
+  st->player_x = player_x;
+  st->player_y = player_y;
+  st->player_xm = player_xm;
+  st->player_ym = player_ym;
+  st->player_angle = player_angle;
+  st->player_alive = player_alive;
+  st->lives = lives;
+  st->score = score;
+  st->level = level;
+  st->world_w = world_w;
+  st->world_h = world_h;
+  st->bullets = &bullets;
+  st->bullets_live = bullet_pool.live;
+  st->num_bullets = bullet_pool.count;
+  st->asteroids = &asteroids;
+  st->asteroids_live = asteroid_pool.live;
+  st->num_asteroids = asteroid_pool.count;
+  st->particles = &particles;
+  st->events = events;
+  st->events_mask = events_mask;
+  st->events_head = events_head;
+  st->events_tail = events_tail;
+}
+
+/* Start a new game from 'seed': */
+
+void
+gym_reset(uint64_t seed)
+{
+  random_seed(seed);
+  sim_counter = 0;
+  sounds_due = 0;
+  game_reset();
+}
+
+/* Step the game with the controls in 'actions' held (and fire pressed, if
+   it is in there); '*reward' is what the step scored.  Returns true once
+   the game is over: */
+
+bool
+gym_step(uint32_t actions, int32_t* reward)
+{
+  size_t before = score;
+  Input input = {
+    .left = actions & ACTION_LEFT,
+    .right = actions & ACTION_RIGHT,
+    .up = actions & ACTION_THRUST,
+    .shift = actions & ACTION_SHIFT,
+    .fire = (actions & ACTION_FIRE ? 1 : 0)};
+
+  bool over = game_step(&input);
+
+  sounds_due = 0;
+  *reward = (int32_t)(score - before);
+  return over;
+}
+
+/* The shortest way from 'from' to 'to' around a wrapping world 'size'
+   pixels across: */
+
+static inline int16_t
+gym_delta(int32_t from, int32_t to, int32_t size)
+{
+  int32_t d = to - from;
+
+  d -= -(d > size / 2) & size;
+  d += -(d < -size / 2) & size;
+  return (int16_t)d;
+}
+
+/* Fill in what the bot sees now (see GymObs): */
+
+void
+gym_observe(GymObs* obs)
+{
+  int32_t px = player_x >> kFixShift, py = player_y >> kFixShift;
+  size_t rocks = (asteroid_pool.count < kGymRocks ? asteroid_pool.count : kGymRocks);
+  size_t shots = (bullet_pool.count < kGymBullets ? bullet_pool.count : kGymBullets);
+
+  obs->ship_x = (int16_t)px;
+  obs->ship_y = (int16_t)py;
+  obs->ship_xm = (int16_t)player_xm;
+  obs->ship_ym = (int16_t)player_ym;
+  obs->ship_angle = (int16_t)player_angle;
+  obs->ship_alive = (uint8_t)player_alive;
+  obs->lives = (uint8_t)(lives < 255 ? lives : 255);
+  obs->num_rocks = (uint8_t)rocks;
+  obs->num_bullets = (uint8_t)shots;
+
+  for (size_t n = 0; n < rocks; n++)
+  {
+    int32_t i = asteroid_pool.live[n];
+
+    obs->rock_dx[n] = gym_delta(px, asteroids.x[i] >> kFixShift, world_w);
+    obs->rock_dy[n] = gym_delta(py, asteroids.y[i] >> kFixShift, world_h);
+    obs->rock_xm[n] = (int16_t)asteroids.xm[i];
+    obs->rock_ym[n] = (int16_t)asteroids.ym[i];
+    obs->rock_size[n] = (uint8_t)asteroids.size[i];
+  }
+
+  for (size_t n = 0; n < shots; n++)
+  {
+    int32_t i = bullet_pool.live[n];
+
+    obs->bullet_dx[n] = gym_delta(px, bullets.x[i] >> kFixShift, world_w);
+    obs->bullet_dy[n] = gym_delta(py, bullets.y[i] >> kFixShift, world_h);
+  }
+}
+
+/* Room to save the game in (free() it when done): */
+
+GymState*
+gym_state_new(void)
+{
+  return malloc(sizeof(GymState) + arena.state);
+}
+
+/* Save the game, or put a saved one back.  Debris is left out (it never
+   affects play), and so are the effects and drawing PRNG streams: */
+
+void
+gym_clone(GymState* st)
+{
+  st->player_x = player_x;
+  st->player_y = player_y;
+  st->player_xm = player_xm;
+  st->player_ym = player_ym;
+  st->player_angle = player_angle;
+  st->player_alive = player_alive;
+  st->player_die_timer = player_die_timer;
+  st->lives = lives;
+  st->score = score;
+  st->level = level;
+  st->sim_counter = sim_counter;
+  st->sap_count = sap_count;
+  st->grid_max_size = grid_max_size;
+  st->text_zoom = text_zoom;
+  memcpy(st->rng, rngstate[RNG_GAME], sizeof(st->rng));
+  st->bullet_pool = bullet_pool;
+  st->asteroid_pool = asteroid_pool;
+  memcpy(st->tables, arena.base, arena.state);
+}
+
+void
+gym_restore(const GymState* st)
+{
+  player_x = st->player_x;
+  player_y = st->player_y;
+  player_xm = st->player_xm;
+  player_ym = st->player_ym;
+  player_angle = st->player_angle;
+  player_alive = st->player_alive;
+  player_die_timer = st->player_die_timer;
+  lives = st->lives;
+  score = st->score;
+  level = st->level;
+  sim_counter = st->sim_counter;
+  sap_count = st->sap_count;
+  grid_max_size = st->grid_max_size;
+  text_zoom = st->text_zoom;
+  memcpy(rngstate[RNG_GAME], st->rng, sizeof(st->rng));
+  bullet_pool = st->bullet_pool;
+  asteroid_pool = st->asteroid_pool;
+  memcpy(arena.base, st->tables, arena.state);
+}
+
+static inline uint64_t
+rotl(const uint64_t x, int k)
+{
+  return (x << k) | (x >> (64 - k));
+}
+
+static inline uint64_t
+random_next(uint64_t s[4])
+{
+  const uint64_t result = rotl(s[0] + s[3], 23) + s[0];
+  const uint64_t t = s[1] << 17;
+  s[2] ^= s[0];
+  s[3] ^= s[1];
+  s[1] ^= s[2];
+  s[0] ^= s[3];
+  s[2] ^= t;
+  s[3] = rotl(s[3], 45);
+  return result;
+}
+
+/* Advance a state by 2^128 draws: */
+
+static void
+random_jump(uint64_t s[4])
+{
+  static const uint64_t jump[4] = {0x180ec6d33cfd0aba, 0xd5a61266f0c9392c, 0xa9582618e03fc9aa, 0x39abdc4529b1661c};
+  uint64_t t[4] = {0};
+
+  for (size_t i = 0; i < 4; i++)
+  {
+    for (int b = 0; b < 64; b++)
+    {
+      if (jump[i] & ((uint64_t)1 << b))
+      {
+        t[0] ^= s[0];
+        t[1] ^= s[1];
+        t[2] ^= s[2];
+        t[3] ^= s[3];
+      }
+      random_next(s);
+    }
+  }
+
+  memcpy(s, t, sizeof(t));
+}
+
+/* Derive every other stream from the gameplay one: */
+
+void
+random_setup(void)
+{
+  for (size_t i = 1; i < NUM_RNG; i++)
+  {
+    memcpy(rngstate[i], rngstate[i - 1], sizeof(rngstate[i]));
+    random_jump(rngstate[i]);
+  }
+}
+
+/* Start every stream over from a 64-bit seed: */
+
+void
+random_seed(uint64_t seed)
+{
+  random_spread(rngstate[RNG_GAME], seed);
+  random_setup();
+}
+
+/* Spread a 64-bit seed over a stream's state with splitmix64 (which is
+   never all zero that way): */
+
+static void
+random_spread(uint64_t s[4], uint64_t seed)
+{
+  for (size_t i = 0; i < 4; i++)
+  {
+    uint64_t z = (seed += 0x9e3779b97f4a7c15);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111eb;
+    s[i] = z ^ (z >> 31);
+  }
+}
+
+/* A number in [0, bound), without the bias (or the 64-bit division) of
+   taking the remainder.  A 32-bit draw times the bound leaves the answer
+   in the high word; only when the low word lands in the 2^32 % bound
+   values that would favour some answers is it drawn again: */
+
+static inline int32_t
+random_below(uint64_t s[4], uint32_t bound)
+{
+  uint64_t m = (uint64_t)(uint32_t)random_next(s) * bound;
+
+  if ((uint32_t)m < bound)
+  {
+    const uint32_t floor = -bound % bound;
+
+    while ((uint32_t)m < floor)
+    {
+      m = (uint64_t)(uint32_t)random_next(s) * bound;
+    }
+  }
+
+  return (int32_t)(m >> 32);
+}
+
+/* Fill out[] with n numbers in [0, bound), the same way, using both halves
+   of every draw and working out the rejection threshold once: */
+
+void
+random_fill(uint64_t s[4], int32_t* out, size_t n, uint32_t bound)
+{
+  assert(bound > 0);
+
+  const uint32_t floor = -bound % bound;
+  size_t i = 0;
+
+  while (i < n)
+  {
+    uint64_t r = random_next(s);
+    uint64_t lo = (uint64_t)(uint32_t)r * bound, hi = (r >> 32) * bound;
+
+    if ((uint32_t)lo >= floor)
+    {
+      out[i++] = (int32_t)(lo >> 32);
+    }
+    if ((uint32_t)hi >= floor && i < n)
+    {
+      out[i++] = (int32_t)(hi >> 32);
+    }
+  }
+}
+
+// Returns a random number in [0, bound), for gameplay
+int32_t
+random_range(uint32_t bound)
+{
+  return random_below(rngstate[RNG_GAME], bound);
+}
+
+// Returns a random number in [0, bound), for effects on the game thread
+int32_t
+random_effect(uint32_t bound)
+{
+  return random_below(rngstate[RNG_EFFECTS], bound);
+}
+
+// Returns a random number in [0, bound), for game_draw() only
+int32_t
+random_fx(uint32_t bound)
+{
+  return random_below(rngstate[RNG_DRAW], bound);
+}
+
+/* Start a new game: */
+
+void
+game_reset(void)
+{
+  lives = 3;
+  score = 0;
+
+  player_alive = 1;
+  player_die_timer = 0;
+  player_angle = 90;
+  player_x = (world_w / 2) << 4;
+  player_y = (world_h / 2) << 4;
+  player_xm = 0;
+  player_ym = 0;
+
+  level = 1;
+  reset_level();
+}
+
+/* Advance the game by one fixed step; returns true once the game is over: */
+
+bool
+game_step(const Input* input)
+{
+  bool over = false;
+
+  ++sim_counter;
+
+  /* Forget the last step's events (handled, and seen by anyone who
+     cared): */
+
+  events_head = events_done = events_tail;
+
+  /* Fire bullets: */
+
+  for (size_t i = 0; i < input->fire && player_alive; ++i)
+  {
+    add_bullet(player_x, player_y, player_angle, player_xm, player_ym);
+  }
+
+  /* Rotate ship: */
+
+  if (input->right)
+  {
+    player_angle -= 8;
+    if (player_angle < 0)
+    {
+      player_angle += 360;
+    }
+  }
+  else if (input->left)
+  {
+    player_angle += 8;
+    if (player_angle >= 360)
+    {
+      player_angle -= 360;
+    }
+  }
+
+  /* Thrust ship: */
+
+  if (input->up && player_alive)
+  {
+    /* Move forward: */
+
+    player_xm += (trig_cos(trig_deg(player_angle)) * 3) >> kTrigShift;
+    player_ym -= (trig_sin(trig_deg(player_angle)) * 3) >> kTrigShift;
+  }
+  else
+  {
+    /* Slow down (unrealistic, but.. feh!) */
+
+    if (!(sim_counter % 20))
+    {
+      player_xm = (player_xm * 7) / 8;
+      player_ym = (player_ym * 7) / 8;
+    }
+  }
+
+  /* Handle player death: */
+
+  if (!player_alive)
+  {
+    --player_die_timer;
+
+    if (player_die_timer <= 0)
+    {
+      if (lives > 0)
+      {
+        /* Reset player: */
+
+        player_die_timer = 0;
+        player_angle = 90;
+        player_x = (world_w / 2) << 4;
+        player_y = (world_h / 2) << 4;
+        player_xm = 0;
+        player_ym = 0;
+
+        /* Only bring player back when it's alright to! */
+
+        player_alive = 1;
+
+        if (!input->shift)
+        {
+          int32_t* near = grid_found;
+          size_t num_near = grid_query(player_x >> 4, player_y >> 4, (screen_w > screen_h ? screen_w : screen_h) / 5, near);
+
+          for (size_t k = 0; k < num_near && player_alive; ++k)
+          {
+            size_t i = near[k];
+
+            if (asteroids.alive[i])
+            {
+              int32_t ax = asteroids.x[i] >> kFixShift, ay = asteroids.y[i] >> kFixShift;
+
+              if (ax >= (player_x >> 4) - (screen_w / 5) && ax <= (player_x >> 4) + (screen_w / 5) && ay >= (player_y >> 4) - (screen_h / 5) && ay <= (player_y >> 4) + (screen_h / 5))
+              {
+                /* If any asteroid is too close for comfort,
+                   don't bring ship back yet! */
+
+                player_alive = 0;
+              }
+            }
+          }
+        }
+      }
+      else
+      {
+        over = true;
+      }
+    }
+  }
+
+  /* Move ship: */
+
+  move_bodies(&player_x, &player_y, &player_xm, &player_ym, 1);
+
+  /* Move bullets: */
+
+  move_bodies(bullets.x, bullets.y, bullets.xm, bullets.ym, bullet_pool.used);
+
+  /* Look for every bullet's hit at once, then apply them one by one, in
+     order, so the score and the new rocks come out the same however the
+     jobs were split: */
+
+  jobs_run(bullets_hit_job, NULL, bullet_pool.count, jobs_chunk(bullet_pool.count, kJobQueryGrain));
+
+  /* (Backwards, as spent bullets are swapped out of the live list:) */
+
+  for (size_t n = bullet_pool.count; n-- > 0;)
+  {
+    size_t i = bullet_pool.live[n];
+    int32_t j = bullet_hits[n];
+
+    /* If an earlier bullet broke that rock up already, look again: */
+
+    if (j != -1 && !bullet_sweeps(i, j, kBulletRadius))
+    {
+      j = grid_first_sweep(i, kBulletRadius);
+    }
+
+    if (j != -1)
+    {
+      /* Remove bullet! */
+
+      bullets.timer[i] = 0;
+
+      hurt_asteroid(j, bullets.xm[i], bullets.ym[i], asteroids.size[j] * 3);
+    }
+
+    if (bullets.timer[i] <= 0)
+    {
+      pool_free(&bullet_pool, i);
+    }
+  }
+
+  /* Move and rotate asteroids: */
+
+  jobs_run(asteroids_move_job, NULL, asteroid_pool.used, jobs_chunk(asteroid_pool.used, kJobGrain));
+
+  if (bounce_rocks)
+  {
+    rocks_bounce();
+  }
+
+  size_t num_asteroids_alive = asteroid_pool.count;
+
+  for (size_t n = 0; n < asteroid_pool.count; ++n)
+  {
+    grid_update(asteroid_pool.live[n]);
+  }
+
+  /* See if we collided with the player: */
+
+  if (player_alive)
+  {
+    int32_t* near = grid_found;
+    size_t num_near = grid_query(player_x >> 4, player_y >> 4, kShipRadius, near);
+    int32_t hit = INT32_MAX;
+
+    /* (The lowest-numbered rock touching the ship is the one it hits:) */
+
+    for (size_t k = 0; k < num_near; ++k)
+    {
+      int32_t i = near[k];
+      int32_t ax = asteroids.x[i] >> kFixShift, ay = asteroids.y[i] >> kFixShift;
+
+      if (i < hit && asteroids.alive[i] && ax >= (player_x >> 4) - kShipRadius && ax <= (player_x >> 4) + kShipRadius && ay >= (player_y >> 4) - kShipRadius && ay <= (player_y >> 4) + kShipRadius)
+      {
+        hit = i;
+      }
+    }
+
+    if (hit != INT32_MAX)
+    {
+      hurt_asteroid(hit, player_xm, player_ym, kNumBits);
+
+      player_alive = 0;
+      player_die_timer = 30;
+
+      events_emit(&(Event){.type = EVT_DEATH});
+    }
+  }
+
+  /* Catch up on what happened: */
+
+  events_process();
+
+  /* Move particles: */
+
+  particles_step();
+
+  /* Zooming level effect: */
+
+  if (text_zoom > 0 && !(sim_counter % 2))
+  {
+    --text_zoom;
+  }
+
+  /* Go to next level? */
+
+  if (!num_asteroids_alive)
+  {
+    ++level;
+
+    reset_level();
+  }
+
+  return over;
+}
+
+/* Wear out live bullets [begin, end) and find the first asteroid (in slot
+   order) each one hit anywhere along its last step, as the asteroids
+   stood when the pass began: */
+
+static void
+bullets_hit_job(void* data, size_t begin, size_t end)
+{
+  (void)data;
+
+  for (size_t n = begin; n < end; n++)
+  {
+    size_t i = bullet_pool.live[n];
+
+    bullets.timer[i]--;
+    bullet_hits[n] = (bullets.timer[i] > 0 ? grid_first_sweep(i, kBulletRadius) : -1);
+  }
+}
+
+/* Move and spin asteroid slots [begin, end) (free slots too; they are
+   never looked at): */
+
+static void
+asteroids_move_job(void* data, size_t begin, size_t end)
+{
+  (void)data;
+
+  move_bodies(asteroids.x + begin, asteroids.y + begin, asteroids.xm + begin, asteroids.ym + begin, end - begin);
+
+  for (size_t i = begin; i < end; i++)
+  {
+    int32_t angle = asteroids.angle[i] + asteroids.angle_m[i];
+
+    /* Wrap rotation angle... */
+
+    angle += -(angle < 0) & 360;
+    angle -= -(angle >= 360) & 360;
+
+    asteroids.angle[i] = angle;
+  }
+}
+
+/* Run fn() over [0, n) in chunks of 'size', in order, on this thread: */
+
+void
+jobs_serial(JobFn fn, void* data, size_t n, size_t size)
+{
+  for (size_t begin = 0; begin < n; begin += size)
+  {
+    fn(data, begin, (begin + size < n ? begin + size : n));
+  }
+}
+
+/* How big the chunks of an 'n' element job should be: 'grain' elements,
+   or more if that makes too many.  It depends on 'n' alone, never on the
+   number of workers, so results are the same however the work is split: */
+
+static size_t
+jobs_chunk(size_t n, size_t grain)
+{
+  size_t size = (n + kJobChunks - 1) / kJobChunks;
+
+  return (size > grain ? size : grain);
+}
+
+/* Hand out the next (cache-line aligned) piece of the arena.  Before the
+   arena exists this only adds up how big it needs to be: */
+
+void*
+arena_alloc(size_t size)
+{
+  size_t at = (arena.used + 63) & ~(size_t)63;
+
+  arena.used = at + size;
+
+  if (!arena.base)
+  {
+    return NULL;
+  }
+
+  if (arena.used > arena.size)
+  {
+    fprintf(stderr, "\nError: The entity tables outgrew their arena!\n\n");
+    exit(1);
+  }
+
+  return arena.base + at;
+}
+
+/* Size the world, and the grid over it (if the world does not divide into
+   whole cells, the first row and column of cells take in what is left): */
+
+void
+world_setup(void)
+{
+  world_w = screen_w * world_scale;
+  world_h = screen_h * world_scale;
+  grid_cols = world_w / kGridCell;
+  grid_rows = world_h / kGridCell;
+
+  /* Pick the fastest way to move things around a world this size: */
+
+  if (world_w == 480 && world_h == 480)
+  {
+    move_bodies = move_bodies_480x480;
+  }
+  else if (world_w == 640 && world_h == 480)
+  {
+    move_bodies = move_bodies_640x480;
+  }
+  else if (!(world_w & (world_w - 1)) && !(world_h & (world_h - 1)))
+  {
+    move_bodies = move_bodies_pow2;
+  }
+  else
+  {
+    move_bodies = move_bodies_any;
+  }
+}
+
+/* Size the arena for the configured capacities, allocate it once, and
+   lay every table out in it: */
+
+void
+arena_setup(void)
+{
+  arena.used = 0;
+  tables_alloc();
+
+  arena.size = arena.used;
+  arena.base = calloc(1, arena.size);
+
+  if (!arena.base)
+  {
+    fprintf(stderr,
+            "\nError: I could not allocate %zu bytes for %zu asteroids, "
+            "%zu bullets and %zu particles!\n\n",
+            arena.size, max_asteroids, max_bullets, max_particles);
+    exit(1);
+  }
+
+  arena.used = 0;
+  tables_alloc();
+}
+
+/* Carve out the game's tables, and then whatever tables_extra() adds: */
+
+static void
+tables_alloc(void)
+{
+  bullets_alloc(&bullets, max_bullets);
+  pool_setup(&bullet_pool, max_bullets);
+
+  asteroids_alloc(&asteroids, max_asteroids);
+  pool_setup(&asteroid_pool, max_asteroids);
+  shapes = arena_alloc(max_asteroids * sizeof(*shapes));
+  grid_head = arena_alloc(grid_cols * grid_rows * sizeof(int32_t));
+  grid_next = arena_alloc(max_asteroids * sizeof(int32_t));
+  grid_prev = arena_alloc(max_asteroids * sizeof(int32_t));
+  grid_cell = arena_alloc(max_asteroids * sizeof(int32_t));
+  sap_order = arena_alloc(max_asteroids * sizeof(int32_t));
+  sap_left = arena_alloc(max_asteroids * sizeof(int32_t));
+  sap_y = arena_alloc(max_asteroids * sizeof(int32_t));
+  sap_r = arena_alloc(max_asteroids * sizeof(int32_t));
+  sap_listed = arena_alloc(max_asteroids * sizeof(uint8_t));
+
+  /* (Everything up to here is game state, which gym_clone() copies in one
+     go; the rest is scratch space, debris and the front end's:) */
+
+  arena.state = arena.used;
+
+  grid_found = arena_alloc(max_asteroids * sizeof(int32_t));
+  bullet_hits = arena_alloc(max_bullets * sizeof(int32_t));
+
+  /* (A step fires, and breaks, at most a pool of bullets' worth, and
+     every rock it breaks may bring an extra life:) */
+
+  size_t n = 8;
+  while (n < 3 * max_bullets + 4)
+  {
+    n <<= 1;
+  }
+
+  events = arena_alloc(n * sizeof(Event));
+  events_mask = n - 1;
+
+  particles_alloc(&particles, max_particles);
+
+  if (tables_extra)
+  {
+    tables_extra();
+  }
+}
+
+static void
+pool_setup(Pool* pool, size_t capacity)
+{
+  pool->next = arena_alloc(capacity * sizeof(int32_t));
+  pool->live = arena_alloc(capacity * sizeof(int32_t));
+  pool->index = arena_alloc(capacity * sizeof(int32_t));
+  pool->capacity = capacity;
+}
+
+void
+bullets_alloc(Bullets* b, size_t n)
+{
+  b->timer = arena_alloc(n * sizeof(int32_t));
+  b->x = arena_alloc(n * sizeof(int32_t));
+  b->y = arena_alloc(n * sizeof(int32_t));
+  b->xm = arena_alloc(n * sizeof(int32_t));
+  b->ym = arena_alloc(n * sizeof(int32_t));
+}
+
+void
+asteroids_alloc(Asteroids* a, size_t n)
+{
+  a->alive = arena_alloc(n * sizeof(int32_t));
+  a->size = arena_alloc(n * sizeof(int32_t));
+  a->x = arena_alloc(n * sizeof(int32_t));
+  a->y = arena_alloc(n * sizeof(int32_t));
+  a->xm = arena_alloc(n * sizeof(int32_t));
+  a->ym = arena_alloc(n * sizeof(int32_t));
+  a->angle = arena_alloc(n * sizeof(int32_t));
+  a->angle_m = arena_alloc(n * sizeof(int32_t));
+}
+
+void
+particles_alloc(Particles* p, size_t n)
+{
+  p->life = arena_alloc(n * sizeof(int32_t));
+  p->x = arena_alloc(n * sizeof(int32_t));
+  p->y = arena_alloc(n * sizeof(int32_t));
+  p->xm = arena_alloc(n * sizeof(int32_t));
+  p->ym = arena_alloc(n * sizeof(int32_t));
+}
+
+/* Read or write the bullet and asteroid tables of the state file: */
+
+void
+state_tables(FILE* fi, bool save)
+{
+  struct
+  {
+    void* p;
+    size_t size;
+  } tables[] = {
+    {bullets.timer, max_bullets * sizeof(int32_t)},
+    {bullets.x, max_bullets * sizeof(int32_t)},
+    {bullets.y, max_bullets * sizeof(int32_t)},
+    {bullets.xm, max_bullets * sizeof(int32_t)},
+    {bullets.ym, max_bullets * sizeof(int32_t)},
+    {asteroids.alive, max_asteroids * sizeof(int32_t)},
+    {asteroids.size, max_asteroids * sizeof(int32_t)},
+    {asteroids.x, max_asteroids * sizeof(int32_t)},
+    {asteroids.y, max_asteroids * sizeof(int32_t)},
+    {asteroids.xm, max_asteroids * sizeof(int32_t)},
+    {asteroids.ym, max_asteroids * sizeof(int32_t)},
+    {asteroids.angle, max_asteroids * sizeof(int32_t)},
+    {asteroids.angle_m, max_asteroids * sizeof(int32_t)},
+    {shapes, max_asteroids * sizeof(*shapes)}};
+
+  for (size_t i = 0; i < sizeof(tables) / sizeof(tables[0]); i++)
+  {
+    if (save)
+    {
+      fwrite(tables[i].p, tables[i].size, 1, fi);
+    }
+    else
+    {
+      fread(tables[i].p, tables[i].size, 1, fi);
+    }
+  }
+}
+
+/* Read capacities from a config file of "name value" lines ('#' starts a
+   comment); a missing file is only an error if it was asked for: */
+
+bool
+config_load(const char* path, bool required)
+{
+  FILE* fi = fopen(path, "r");
+  char line[256] = {0};
+  size_t n = 0;
+
+  if (!fi)
+  {
+    if (required)
+    {
+      fprintf(stderr, "\nError: I could not open the config file %s: %s\n\n", path, strerror(errno));
+    }
+    return !required;
+  }
+
+  while (fgets(line, sizeof(line), fi))
+  {
+    char key[32] = {0}, value[32] = {0};
+
+    ++n;
+    line[strcspn(line, "#")] = '\0';
+
+    for (char* c = line; *c; c++)
+    {
+      if (*c == '=')
+      {
+        *c = ' ';
+      }
+    }
+
+    int fields = sscanf(line, "%31s %31s", key, value);
+
+    if (fields <= 0)
+    {
+      continue;
+    }
+
+    if (fields != 2 || !config_set(key, value))
+    {
+      fprintf(stderr, "\nWarning: Ignoring line %zu of %s.\n", n, path);
+    }
+  }
+
+  fclose(fi);
+  return true;
+}
+
+/* Set one capacity by name ("bullets", "asteroids", "particles", "stress",
+   "jobs", "world" or "size", the last as WIDTHxHEIGHT), if the value makes
+   sense for it: */
+
+bool
+config_set(const char* key, const char* value)
+{
+  char* end = NULL;
+  unsigned long v = 0;
+
+  if (strcmp(key, "size") == 0)
+  {
+    int w = 0, h = 0;
+    char extra = 0;
+
+    if (sscanf(value, "%dx%d%c", &w, &h, &extra) != 2 || w < kScreenMin || w > kScreenMax || h < kScreenMin || h > kScreenMax)
+    {
+      return false;
+    }
+
+    screen_w = w;
+    screen_h = h;
+    return true;
+  }
+
+  v = strtoul(value, &end, 10);
+
+  if (end == value || *end || value[0] == '-' || v > kMaxCapacity)
+  {
+    return false;
+  }
+
+  if (strcmp(key, "bullets") == 0 && v > 0)
+  {
+    max_bullets = v;
+  }
+  else if (strcmp(key, "asteroids") == 0 && v > 0)
+  {
+    max_asteroids = v;
+  }
+  else if (strcmp(key, "particles") == 0)
+  {
+    max_particles = v;
+  }
+  else if (strcmp(key, "stress") == 0 && v < kMaxCapacity / kStressSplits)
+  {
+    stress_rocks = v;
+  }
+  else if (strcmp(key, "jobs") == 0 && v <= kMaxWorkers)
+  {
+    job_workers = v;
+  }
+  else if (strcmp(key, "world") == 0 && v >= 1 && v <= kMaxWorld)
+  {
+    world_scale = v;
+  }
+  else if (strcmp(key, "bounce") == 0 && v <= 1)
+  {
+    bounce_rocks = v;
+  }
+  else
+  {
+    return false;
+  }
+
+  return true;
+}
+
+/* Convert degrees to a binary angle, rounded (kTrigSize / 360 in 22.10
+   fixed point): */
+
+int32_t
+trig_deg(int32_t deg)
+{
+  return ((deg * 11651 + 512) >> 10);
+}
+
+/* Q1.14 sine and cosine of a binary angle.  Any angle works, negative ones
+   included, since the mask wraps it into the table: */
+
+int32_t
+trig_sin(int32_t a)
+{
+  return (sin_table[a & (kTrigSize - 1)]);
+}
+
+int32_t
+trig_cos(int32_t a)
+{
+  return (sin_table[(a & (kTrigSize - 1)) + kTrigSize / 4]);
+}
+
+/* Sine and cosine of n binary angles at once: */
+
+void
+trig_sincos(const int32_t* restrict a, int32_t* restrict s, int32_t* restrict c, size_t n)
+{
+  for (size_t i = 0; i < n; i++)
+  {
+    int32_t k = a[i] & (kTrigSize - 1);
+
+    s[i] = sin_table[k];
+    c[i] = sin_table[k + kTrigSize / 4];
+  }
+}
+
+/* Move and wrap 'n' bodies one step in a 'w' by 'h' world (in fixed point
+   units); four at a time where the compiler offers vector types.  If the
+   sizes are powers of two, wrapping is just a mask.  This is inlined into
+   each version below, so that they can all be constants: */
+
+#if defined(__GNUC__)
+typedef int32_t vec4i __attribute__((vector_size(16)));
+typedef int64_t vec4l __attribute__((vector_size(32)));
+#define ALWAYS_INLINE __attribute__((always_inline))
+#else
+#define ALWAYS_INLINE
+#endif
+
+static inline ALWAYS_INLINE void
+move_wrap(int32_t* restrict x, int32_t* restrict y, const int32_t* restrict xm, const int32_t* restrict ym, size_t n, const int32_t w, const int32_t h, const bool pow2)
+{
+  size_t i = 0;
+
+#if defined(__GNUC__)
+  const vec4i zero = {0, 0, 0, 0};
+  const vec4i vw = {w, w, w, w};
+  const vec4i vh = {h, h, h, h};
+
+  for (; i + 4 <= n; i += 4)
+  {
+    vec4i vx, vy, vxm, vym;
+
+    memcpy(&vx, x + i, sizeof(vx));
+    memcpy(&vy, y + i, sizeof(vy));
+    memcpy(&vxm, xm + i, sizeof(vxm));
+    memcpy(&vym, ym + i, sizeof(vym));
+
+    vx += vxm;
+    vy += vym;
+
+    if (pow2)
+    {
+      vx &= vw - 1;
+      vy &= vh - 1;
+    }
+    else
+    {
+      /* (Comparisons give all-ones lanes where true:) */
+
+      vx += (vx < zero) & vw;
+      vx -= (vx >= vw) & vw;
+      vy += (vy < zero) & vh;
+      vy -= (vy >= vh) & vh;
+    }
+
+    memcpy(x + i, &vx, sizeof(vx));
+    memcpy(y + i, &vy, sizeof(vy));
+  }
+#endif
+
+  for (; i < n; i++)
+  {
+    int32_t nx = x[i] + xm[i], ny = y[i] + ym[i];
+
+    if (pow2)
+    {
+      nx &= w - 1;
+      ny &= h - 1;
+    }
+    else
+    {
+      nx += -(nx < 0) & w;
+      nx -= -(nx >= w) & w;
+      ny += -(ny < 0) & h;
+      ny -= -(ny >= h) & h;
+    }
+
+    x[i] = nx;
+    y[i] = ny;
+  }
+}
+
+/* The common screen sizes (as one-screen worlds): */
+
+static void
+move_bodies_480x480(int32_t* restrict x, int32_t* restrict y, const int32_t* restrict xm, const int32_t* restrict ym, size_t n)
+{
+  move_wrap(x, y, xm, ym, n, 480 * kFixOne, 480 * kFixOne, false);
+}
+
+static void
+move_bodies_640x480(int32_t* restrict x, int32_t* restrict y, const int32_t* restrict xm, const int32_t* restrict ym, size_t n)
+{
+  move_wrap(x, y, xm, ym, n, 640 * kFixOne, 480 * kFixOne, false);
+}
+
+/* Any world whose sides are powers of two, and any other at all: */
+
+static void
+move_bodies_pow2(int32_t* restrict x, int32_t* restrict y, const int32_t* restrict xm, const int32_t* restrict ym, size_t n)
+{
+  move_wrap(x, y, xm, ym, n, world_w * kFixOne, world_h * kFixOne, true);
+}
+
+static void
+move_bodies_any(int32_t* restrict x, int32_t* restrict y, const int32_t* restrict xm, const int32_t* restrict ym, size_t n)
+{
+  move_wrap(x, y, xm, ym, n, world_w * kFixOne, world_h * kFixOne, false);
+}
+
+/* Put every slot back on the free list (lowest first): */
+
+static void
+pool_clear(Pool* pool)
+{
+  for (size_t i = 0; i < pool->capacity; i++)
+  {
+    pool->next[i] = (i + 1 < pool->capacity ? (int32_t)(i + 1) : -1);
+    pool->index[i] = -1;
+  }
+
+  pool->free = (pool->capacity ? 0 : -1);
+  pool->count = 0;
+  pool->used = 0;
+}
+
+/* Recreate the lists from a table whose slots are in use where
+   'in_use' is positive (e.g. after loading a saved game): */
+
+void
+pool_rebuild(Pool* pool, const int32_t* in_use)
+{
+  pool->free = -1;
+  pool->count = 0;
+  pool->used = 0;
+
+  for (size_t i = pool->capacity; i-- > 0;)
+  {
+    if (in_use[i] > 0)
+    {
+      if (!pool->used)
+      {
+        pool->used = i + 1;
+      }
+    }
+    else
+    {
+      pool->next[i] = pool->free;
+      pool->index[i] = -1;
+      pool->free = i;
+    }
+  }
+
+  for (size_t i = 0; i < pool->used; i++)
+  {
+    if (in_use[i] > 0)
+    {
+      pool->index[i] = pool->count;
+      pool->live[pool->count++] = i;
+    }
+  }
+}
+
+/* Take a free slot, or return -1 (and count the drop) if there is none: */
+
+static int32_t
+pool_alloc(Pool* pool)
+{
+  int32_t slot = pool->free;
+
+  if (slot == -1)
+  {
+    pool->dropped++;
+    return -1;
+  }
+
+  pool->free = pool->next[slot];
+  pool->index[slot] = pool->count;
+  pool->live[pool->count++] = slot;
+
+  if ((size_t)slot >= pool->used)
+  {
+    pool->used = slot + 1;
+  }
+
+  return slot;
+}
+
+/* Give a slot back; the last live slot takes its place in the list: */
+
+static void
+pool_free(Pool* pool, int32_t slot)
+{
+  int32_t k = pool->index[slot];
+
+  if (k == -1)
+  {
+    return;
+  }
+
+  int32_t last = pool->live[--pool->count];
+
+  pool->live[k] = last;
+  pool->index[last] = k;
+  pool->index[slot] = -1;
+  pool->next[slot] = pool->free;
+  pool->free = slot;
+}
+
+/* Spray a burst of particles (as many as there is room for): */
+
+static void
+particles_emit(const Emitter* e)
+{
+  const int32_t w = world_w * kFixOne, h = world_h * kFixOne;
+  const uint32_t spread = 2 * e->radius + 1, jitter = 2 * e->speed + 1;
+  size_t n = e->count;
+
+  if (n > max_particles - particles.count)
+  {
+    n = max_particles - particles.count;
+    particles_dropped += e->count - n;
+  }
+
+  /* Offsets and speeds are drawn kRandomBatch particles at a time: */
+
+  int32_t pos[2 * kRandomBatch], vel[2 * kRandomBatch];
+
+  for (size_t k = 0; k < n; k += kRandomBatch)
+  {
+    size_t m = n - k < kRandomBatch ? n - k : kRandomBatch;
+
+    random_fill(rngstate[RNG_EFFECTS], pos, 2 * m, spread);
+    random_fill(rngstate[RNG_EFFECTS], vel, 2 * m, jitter);
+
+    for (size_t j = 0; j < m; j++)
+    {
+      size_t i = particles.count++;
+      int32_t x = e->x + pos[2 * j] - e->radius;
+      int32_t y = e->y + pos[2 * j + 1] - e->radius;
+
+      x += -(x < 0) & w;
+      x -= -(x >= w) & w;
+      y += -(y < 0) & h;
+      y -= -(y >= h) & h;
+
+      particles.life[i] = e->life;
+      particles.x[i] = x;
+      particles.y[i] = y;
+      particles.xm[i] = e->xm + vel[2 * j] - e->speed;
+      particles.ym[i] = e->ym + vel[2 * j + 1] - e->speed;
+    }
+  }
+}
+
+/* Move every live particle, age them, and pack the survivors.  Each chunk
+   packs its own, and then the chunks are closed up in order: */
+
+static void
+particles_step(void)
+{
+  size_t size = jobs_chunk(particles.count, kJobGrain);
+  size_t n = 0;
+
+  jobs_run(particles_step_job, &size, particles.count, size);
+
+  for (size_t c = 0, begin = 0; begin < particles.count; c++, begin += size)
+  {
+    size_t k = job_counts[c] * sizeof(int32_t);
+
+    if (n != begin)
+    {
+      memmove(particles.life + n, particles.life + begin, k);
+      memmove(particles.x + n, particles.x + begin, k);
+      memmove(particles.y + n, particles.y + begin, k);
+      memmove(particles.xm + n, particles.xm + begin, k);
+      memmove(particles.ym + n, particles.ym + begin, k);
+    }
+
+    n += job_counts[c];
+  }
+
+  particles.count = n;
+}
+
+/* Step particles [begin, end), packing the survivors to the front of the
+   chunk and counting them (in job_counts[], by chunk): */
+
+static void
+particles_step_job(void* data, size_t begin, size_t end)
+{
+  size_t n = begin;
+
+  move_bodies(particles.x + begin, particles.y + begin, particles.xm + begin, particles.ym + begin, end - begin);
+
+  for (size_t i = begin; i < end; i++)
+  {
+    int32_t life = particles.life[i] - 1;
+
+    particles.life[n] = life;
+    particles.x[n] = particles.x[i];
+    particles.y[n] = particles.y[i];
+    particles.xm[n] = particles.xm[i];
+    particles.ym[n] = particles.ym[i];
+
+    n += (life > 0);
+  }
+
+  job_counts[begin / *(const size_t*)data] = n - begin;
+}
+
+/* Add a bullet: */
+
+static void
+add_bullet(int32_t x, int32_t y, int32_t a, int32_t xm, int32_t ym)
+{
+  int32_t found = -1;
+
+  /* (Running out of bullets is part of the game, not a dropped spawn:) */
+
+  if (bullet_pool.count < bullet_pool.capacity)
+  {
+    found = pool_alloc(&bullet_pool);
+  }
+
+  if (found != -1)
+  {
+    bullets.timer[found] = 50;
+
+    bullets.x[found] = x;
+    bullets.y[found] = y;
+
+    bullets.xm[found] = ((trig_cos(trig_deg(a)) * kBulletSpeed * kFixOne) >> kTrigShift) + xm;
+    bullets.ym[found] = -((trig_sin(trig_deg(a)) * kBulletSpeed * kFixOne) >> kTrigShift) + ym;
+
+    events_emit(&(Event){.type = EVT_SHOT});
+  }
+}
+
+/* Add an asteroid: */
+
+void
+add_asteroid(int32_t x, int32_t y, int32_t xm, int32_t ym, int32_t size)
+{
+  int32_t found = 0;
+
+  /* Find a slot: */
+
+  found = pool_alloc(&asteroid_pool);
+
+  /* Hack: No asteroids should be stationary! */
+
+  while (xm == 0)
+  {
+    xm = (random_range(3) - 1) * (kFixOne / kAsteroidsStep);
+  }
+
+  if (found != -1)
+  {
+    asteroids.alive[found] = 1;
+
+    asteroids.x[found] = x;
+    asteroids.y[found] = y;
+    asteroids.xm[found] = xm;
+    asteroids.ym[found] = ym;
+
+    asteroids.angle[found] = random_range(360);
+    asteroids.angle_m[found] = random_range(6) - 3;
+
+    asteroids.size[found] = size;
+
+    grid_insert(found);
+
+    for (size_t i = 0; i < kAsteroidsSides; i++)
+    {
+      shapes[found][i].radius = random_range(3);
+      shapes[found][i].angle = i * 60 + random_range(40);
+    }
+  }
+}
+
+/* Empty the asteroid grid: */
+
+static void
+grid_clear(void)
+{
+  for (size_t c = 0; c < (size_t)(grid_cols * grid_rows); c++)
+  {
+    grid_head[c] = -1;
+  }
+
+  for (size_t i = 0; i < max_asteroids; i++)
+  {
+    grid_cell[i] = -1;
+  }
+
+  grid_max_size = 0;
+}
+
+/* Fill the asteroid grid from scratch: */
+
+void
+grid_rebuild(void)
+{
+  grid_clear();
+
+  for (size_t i = 0; i < max_asteroids; i++)
+  {
+    if (asteroids.alive[i])
+    {
+      grid_insert(i);
+    }
+  }
+}
+
+/* Put an asteroid into the cell under its center: */
+
+static void
+grid_insert(int32_t i)
+{
+  int32_t c = grid_index(asteroids.y[i] >> kFixShift, grid_rows) * grid_cols + grid_index(asteroids.x[i] >> kFixShift, grid_cols);
+
+  grid_cell[i] = c;
+  grid_prev[i] = -1;
+  grid_next[i] = grid_head[c];
+
+  if (grid_head[c] != -1)
+  {
+    grid_prev[grid_head[c]] = i;
+  }
+  grid_head[c] = i;
+
+  if (asteroids.size[i] > grid_max_size)
+  {
+    grid_max_size = asteroids.size[i];
+  }
+}
+
+/* Take an asteroid out of the grid (if it is in it): */
+
+static void
+grid_remove(int32_t i)
+{
+  int32_t c = grid_cell[i];
+
+  if (c == -1)
+  {
+    return;
+  }
+
+  if (grid_prev[i] != -1)
+  {
+    grid_next[grid_prev[i]] = grid_next[i];
+  }
+  else
+  {
+    grid_head[c] = grid_next[i];
+  }
+
+  if (grid_next[i] != -1)
+  {
+    grid_prev[grid_next[i]] = grid_prev[i];
+  }
+
+  grid_cell[i] = -1;
+}
+
+/* Move an asteroid to another cell, if it crossed into one: */
+
+static void
+grid_update(int32_t i)
+{
+  int32_t c = grid_index(asteroids.y[i] >> kFixShift, grid_rows) * grid_cols + grid_index(asteroids.x[i] >> kFixShift, grid_cols);
+
+  if (c != grid_cell[i])
+  {
+    grid_remove(i);
+    grid_insert(i);
+  }
+}
+
+/* Find every asteroid that could touch a circle of radius 'r' around
+   (x, y), wrapping around the screen edges.  Results come cell by cell,
+   in no particular slot order; a caller that must resolve collisions as a
+   plain scan would keeps the lowest slot it hits itself: */
+
+static size_t
+grid_query(int32_t x, int32_t y, int32_t r, int32_t* out)
+{
+  size_t n = 0;
+  int32_t reach = r + grid_max_size * kAsteroidsRadius;
+  int32_t x0 = x - reach, x1 = x + reach;
+  int32_t y0 = y - reach, y1 = y + reach;
+  int32_t cols = (x1 - x0) / kGridCell + 2;
+  int32_t rows = (y1 - y0) / kGridCell + 2;
+
+  if (cols > grid_cols)
+  {
+    cols = grid_cols;
+  }
+  if (rows > grid_rows)
+  {
+    rows = grid_rows;
+  }
+
+  int32_t col0 = grid_index(x0, grid_cols);
+  int32_t row0 = grid_index(y0, grid_rows);
+
+  for (int32_t row = 0; row < rows; row++)
+  {
+    int32_t cy = (row0 + row) % grid_rows;
+
+    for (int32_t col = 0; col < cols; col++)
+    {
+      int32_t cx = (col0 + col) % grid_cols;
+
+      for (int32_t i = grid_head[cy * grid_cols + cx]; i != -1; i = grid_next[i])
+      {
+        out[n++] = i;
+      }
+    }
+  }
+
+  return n;
+}
+
+/* Does the path from (dx - vx, dy - vy) to (dx, dy) -- a bullet's last
+   step, in 1/16 pixels from a rock's center -- pass within 'rad' of it?
+   Either end may be inside, or else the point nearest the center must lie
+   between the ends and inside.  No branches and no division (sweep_first()
+   does the same sums four rocks at a time): */
+
+static inline int32_t
+sweep_hits(int32_t dx, int32_t dy, int32_t vx, int32_t vy, int32_t rad)
+{
+  const int64_t ex = dx - vx, ey = dy - vy;
+  const int64_t rr = (int64_t)rad * rad;
+  const int64_t vv = (int64_t)vx * vx + (int64_t)vy * vy;
+  const int64_t along = -(ex * vx + ey * vy);
+  const int64_t cross = ex * vy - ey * vx;
+
+  return ((int64_t)dx * dx + (int64_t)dy * dy <= rr) | (ex * ex + ey * ey <= rr) | ((along > 0) & (along < vv) & (cross * cross <= rr * vv));
+}
+
+#if defined(__GNUC__)
+
+/* The shortest way across a wrapping world 'size' across, and
+   sweep_hits(), four lanes at a time (the products need 64-bit lanes; a
+   hit is all ones): */
+
+static inline vec4i
+short_way4(vec4i d, vec4i size)
+{
+  const vec4i half = size / 2;
+
+  d -= (d > half) & size;
+  d += (d < -half) & size;
+  return d;
+}
+
+static inline vec4i
+sweep_hits4(vec4i dx32, vec4i dy32, vec4i vx32, vec4i vy32, vec4i rad32)
+{
+  const vec4l dx = __builtin_convertvector(dx32, vec4l), dy = __builtin_convertvector(dy32, vec4l);
+  const vec4l vx = __builtin_convertvector(vx32, vec4l), vy = __builtin_convertvector(vy32, vec4l);
+  const vec4l r = __builtin_convertvector(rad32, vec4l);
+  const vec4l zero = {0, 0, 0, 0};
+  const vec4l rr = r * r;
+  const vec4l vv = vx * vx + vy * vy;
+  const vec4l ex = dx - vx, ey = dy - vy;
+  const vec4l along = -(ex * vx + ey * vy);
+  const vec4l cross = ex * vy - ey * vx;
+  const vec4l hit = (dx * dx + dy * dy <= rr) | (ex * ex + ey * ey <= rr) | ((along > zero) & (along < vv) & (cross * cross <= rr * vv));
+
+  return __builtin_convertvector(hit, vec4i);
+}
+
+#endif
+
+/* The lowest of cand[0..m) whose rock bullet 'i' swept through, or
+   'first' if that is lower (or no rock was hit).  Four rocks at a time
+   where the compiler offers vector types, the rest one by one: */
+
+static inline int32_t
+sweep_first(size_t i, const int32_t* cand, const int32_t* ax, const int32_t* ay, const int32_t* rad, size_t m, int32_t first)
+{
+  const int32_t w = world_w * kFixOne, h = world_h * kFixOne;
+  const int32_t bx = bullets.x[i], by = bullets.y[i];
+  const int32_t vx = bullets.xm[i], vy = bullets.ym[i];
+  size_t k = 0;
+
+#if defined(__GNUC__)
+  const vec4i vw = {w, w, w, w}, vh = {h, h, h, h};
+  const vec4i vbx = {bx, bx, bx, bx}, vby = {by, by, by, by};
+  const vec4i vvx = {vx, vx, vx, vx}, vvy = {vy, vy, vy, vy};
+  vec4i best = {first, first, first, first};
+
+  for (; k < (m & ~(size_t)3); k += 4)
+  {
+    vec4i vax, vay, vrad, vcand;
+
+    memcpy(&vax, ax + k, sizeof(vax));
+    memcpy(&vay, ay + k, sizeof(vay));
+    memcpy(&vrad, rad + k, sizeof(vrad));
+    memcpy(&vcand, cand + k, sizeof(vcand));
+
+    const vec4i hit = sweep_hits4(short_way4(vbx - vax, vw), short_way4(vby - vay, vh), vvx, vvy, vrad);
+
+    /* (Misses become INT32_MAX, and the lowest so far is kept, by
+       masks:) */
+
+    const vec4i j = (vcand | ~hit) & INT32_MAX;
+    const vec4i lower = j < best;
+
+    best = (j & lower) | (best & ~lower);
+  }
+
+  for (size_t n = 0; n < 4; n++)
+  {
+    first = (best[n] < first ? best[n] : first);
+  }
+#endif
+
+  for (; k < m; k++)
+  {
+    /* (The shortest way around the wrapped world:) */
+
+    int32_t dx = bx - ax[k], dy = by - ay[k];
+
+    dx -= -(dx > w / 2) & w;
+    dx += -(dx < -w / 2) & w;
+    dy -= -(dy > h / 2) & h;
+    dy += -(dy < -h / 2) & h;
+
+    /* (A miss becomes INT32_MAX, with a mask, not a branch:) */
+
+    int32_t j = (cand[k] | (sweep_hits(dx, dy, vx, vy, rad[k]) - 1)) & INT32_MAX;
+
+    first = (j < first ? j : first);
+  }
+
+  return first;
+}
+
+/* Did bullet 'i' pass within 'r' pixels of live asteroid 'j' on its way
+   here? */
+
+static bool
+bullet_sweeps(size_t i, int32_t j, int32_t r)
+{
+  int32_t rad = (asteroids.size[j] * kAsteroidsRadius + r) * kFixOne;
+
+  return (asteroids.alive[j] && sweep_first(i, &j, &asteroids.x[j], &asteroids.y[j], &rad, 1, INT32_MAX) == j);
+}
+
+/* The lowest-numbered asteroid bullet 'i' passed within 'r' pixels of on
+   its last step, or -1; the same one a scan of every rock would find
+   first.  Rocks near the step are gathered kSweepBatch at a time and
+   tested together, with no shared buffer, so any number of threads can
+   ask at once: */
+
+static int32_t
+grid_first_sweep(size_t i, int32_t r)
+{
+  int32_t cand[kSweepBatch], ax[kSweepBatch], ay[kSweepBatch], rad[kSweepBatch];
+  size_t m = 0;
+  int32_t first = INT32_MAX;
+
+  /* (Search around the middle of the step, far enough to take all of it
+     in:) */
+
+  const int32_t vx = bullets.xm[i], vy = bullets.ym[i];
+  int32_t x = (bullets.x[i] - vx / 2) >> kFixShift, y = (bullets.y[i] - vy / 2) >> kFixShift;
+  int32_t reach = r + grid_max_size * kAsteroidsRadius + ((vx < 0 ? -vx : vx) + (vy < 0 ? -vy : vy)) / (2 * kFixOne) + 2;
+  int32_t cols = (2 * reach) / kGridCell + 2;
+  int32_t rows = (2 * reach) / kGridCell + 2;
+
+  if (cols > grid_cols)
+  {
+    cols = grid_cols;
+  }
+  if (rows > grid_rows)
+  {
+    rows = grid_rows;
+  }
+
+  int32_t col0 = grid_index(x - reach, grid_cols);
+  int32_t row0 = grid_index(y - reach, grid_rows);
+
+  /* (Only near an edge can the nearest copy of a rock be across it:) */
+
+  const bool edge = (x < reach || y < reach || x >= world_w - reach || y >= world_h - reach);
+
+  for (int32_t row = 0; row < rows; row++)
+  {
+    int32_t cy = (row0 + row) % grid_rows;
+
+    for (int32_t col = 0; col < cols; col++)
+    {
+      int32_t cx = (col0 + col) % grid_cols;
+
+      for (int32_t j = grid_head[cy * grid_cols + cx]; j != -1; j = grid_next[j])
+      {
+        if (j > first)
+        {
+          continue;
+        }
+
+        int32_t dx = x - (asteroids.x[j] >> kFixShift), dy = y - (asteroids.y[j] >> kFixShift);
+        int32_t near = reach - (grid_max_size - asteroids.size[j]) * kAsteroidsRadius;
+
+        if (edge)
+        {
+          dx -= -(dx > world_w / 2) & world_w;
+          dx += -(dx < -world_w / 2) & world_w;
+          dy -= -(dy > world_h / 2) & world_h;
+          dy += -(dy < -world_h / 2) & world_h;
+        }
+
+        if (dx > near || dx < -near || dy > near || dy < -near)
+        {
+          continue;
+        }
+
+        cand[m] = j;
+        ax[m] = asteroids.x[j];
+        ay[m] = asteroids.y[j];
+        rad[m] = (asteroids.size[j] * kAsteroidsRadius + r) * kFixOne;
+
+        if (++m == kSweepBatch)
+        {
+          first = sweep_first(i, cand, ax, ay, rad, m, first);
+          m = 0;
+        }
+      }
+    }
+  }
+
+  first = sweep_first(i, cand, ax, ay, rad, m, first);
+
+  return (first == INT32_MAX ? -1 : first);
+}
+
+/* Are two rocks 'dy' apart up and down within 'reach' of each other (the
+   short way around a world 'h' high)? */
+
+static inline bool
+sap_overlap(int32_t dy, int32_t reach, int32_t h)
+{
+  dy -= -(dy > h / 2) & h;
+  dy += -(dy < -h / 2) & h;
+
+  return ((uint32_t)(dy + reach) < (uint32_t)(2 * reach));
+}
+
+/* Take every rock away, and start bounce mode's sweep (and its count of
+   pairs tested) over: */
+
+void
+rocks_clear(void)
+{
+  for (size_t i = 0; i < max_asteroids; i++)
+  {
+    asteroids.alive[i] = 0;
+    sap_listed[i] = 0;
+  }
+
+  pool_clear(&asteroid_pool);
+  grid_clear();
+  sap_count = 0;
+  sap_tests = 0;
+}
+
+/* Bounce every pair of touching rocks off each other, returning how many
+   bounced.  The sweep runs along the rocks in order of their left edges,
+   so each one is only looked at against those starting before its right
+   edge, and only tested properly if they overlap up and down as well.
+   That order is kept from the last step, with gone rocks taken out and
+   new ones put at the end; the rocks hardly move in a step, so the
+   insertion sort that restores it is close to linear: */
+
+size_t
+rocks_bounce(void)
+{
+  const int32_t w = world_w * kFixOne, h = world_h * kFixOne;
+  const int32_t max_r = grid_max_size * kAsteroidsRadius * kFixOne;
+  size_t n = 0, bounces = 0;
+
+  for (size_t k = 0; k < sap_count; k++)
+  {
+    int32_t i = sap_order[k];
+
+    if (asteroids.alive[i])
+    {
+      sap_order[n++] = i;
+    }
+    else
+    {
+      sap_listed[i] = 0;
+    }
+  }
+
+  for (size_t k = 0; k < asteroid_pool.count; k++)
+  {
+    int32_t i = asteroid_pool.live[k];
+
+    if (!sap_listed[i])
+    {
+      sap_listed[i] = 1;
+      sap_order[n++] = i;
+    }
+  }
+
+  sap_count = n;
+
+  for (size_t k = 0; k < n; k++)
+  {
+    int32_t i = sap_order[k];
+    int32_t left = asteroids.x[i] - asteroids.size[i] * kAsteroidsRadius * kFixOne;
+    size_t m = k;
+
+    while (m > 0 && sap_left[m - 1] > left)
+    {
+      sap_order[m] = sap_order[m - 1];
+      sap_left[m] = sap_left[m - 1];
+      m--;
+    }
+
+    sap_order[m] = i;
+    sap_left[m] = left;
+  }
+
+  for (size_t k = 0; k < n; k++)
+  {
+    int32_t i = sap_order[k];
+
+    sap_y[k] = asteroids.y[i];
+    sap_r[k] = asteroids.size[i] * kAsteroidsRadius * kFixOne;
+  }
+
+  /* (Through locals, which the bounces cannot change under us:) */
+
+  const int32_t* left = sap_left;
+  const int32_t* ys = sap_y;
+  const int32_t* rs = sap_r;
+
+  for (size_t k = 0; k < n; k++)
+  {
+    const int32_t y = ys[k], r = rs[k], right = left[k] + 2 * r;
+
+    for (size_t m = k + 1; m < n && left[m] <= right; m++)
+    {
+      if (sap_overlap(ys[m] - y, rs[m] + r, h))
+      {
+        bounces += rocks_touch(sap_order[k], sap_order[m]);
+      }
+    }
+  }
+
+  /* Rocks poking out past the right edge of the world can touch the first
+     ones in the order, across it: */
+
+  for (size_t k = n; k-- > 0 && left[k] + 2 * max_r >= left[0] + w;)
+  {
+    const int32_t y = ys[k], r = rs[k], right = left[k] + 2 * r - w;
+
+    for (size_t m = 0; m < k && left[m] <= right; m++)
+    {
+      if (sap_overlap(ys[m] - y, rs[m] + r, h))
+      {
+        bounces += rocks_touch(sap_order[m], sap_order[k]);
+      }
+    }
+  }
+
+  return bounces;
+}
+
+/* n / d (d > 0), rounded to nearest rather than toward zero, as rocks
+   move slowly enough that always rounding down would bleed their speed
+   away over a few bounces.  (Rounding either way jiggles them a little,
+   which is why bounces also cap the speed at kAsteroidsMaxSpeed pixels
+   a step, so a crowd cannot heat up forever:) */
+
+static inline int32_t
+rocks_share(int64_t n, int64_t d)
+{
+  return (int32_t)(n >= 0 ? (n + d / 2) / d : -((d / 2 - n) / d));
+}
+
+static inline int32_t
+rocks_cap(int32_t v)
+{
+  const int32_t cap = kAsteroidsMaxSpeed * kFixOne;
+
+  return (v > cap ? cap : (v < -cap ? -cap : v));
+}
+
+/* If rocks 'a' and 'b' overlap and are closing in, trade momentum along
+   the line between their centers, as equally springy balls would (with
+   masses going by area).  Returns whether they bounced: */
+
+static bool
+rocks_touch(int32_t a, int32_t b)
+{
+  const int32_t w = world_w * kFixOne, h = world_h * kFixOne;
+  int32_t dx = asteroids.x[b] - asteroids.x[a], dy = asteroids.y[b] - asteroids.y[a];
+
+  sap_tests++;
+
+  dx -= -(dx > w / 2) & w;
+  dx += -(dx < -w / 2) & w;
+  dy -= -(dy > h / 2) & h;
+  dy += -(dy < -h / 2) & h;
+
+  const int64_t reach = (asteroids.size[a] + asteroids.size[b]) * kAsteroidsRadius * kFixOne;
+  const int64_t dd = (int64_t)dx * dx + (int64_t)dy * dy;
+
+  if (dd >= reach * reach || dd == 0)
+  {
+    return false;
+  }
+
+  const int64_t closing = (int64_t)(asteroids.xm[a] - asteroids.xm[b]) * dx + (int64_t)(asteroids.ym[a] - asteroids.ym[b]) * dy;
+
+  if (closing <= 0)
+  {
+    return false;
+  }
+
+  const int64_t ma = asteroids.size[a] * asteroids.size[a], mb = asteroids.size[b] * asteroids.size[b];
+  const int64_t den = (ma + mb) * dd;
+
+  asteroids.xm[a] = rocks_cap(asteroids.xm[a] - rocks_share(2 * mb * closing * dx, den));
+  asteroids.ym[a] = rocks_cap(asteroids.ym[a] - rocks_share(2 * mb * closing * dy, den));
+  asteroids.xm[b] = rocks_cap(asteroids.xm[b] + rocks_share(2 * ma * closing * dx, den));
+  asteroids.ym[b] = rocks_cap(asteroids.ym[b] + rocks_share(2 * ma * closing * dy, den));
+
+  return true;
+}
+
+/* Post an event (dropping it if the ring is somehow full): */
+
+static void
+events_emit(const Event* e)
+{
+  if (events_tail - events_head > events_mask)
+  {
+    events_dropped++;
+    return;
+  }
+
+  events[events_tail++ & events_mask] = *e;
+}
+
+/* Handle the step's events, in the order they happened (so points and
+   lives add up as they did): every broken rock gets its debris at once,
+   and the sounds they call for are left in 'sounds_due' (each just once
+   per step, however many asked for it): */
+
+static void
+events_process(void)
+{
+  uint32_t due = 0;
+
+  for (; events_done != events_tail; events_done++)
+  {
+    const Event* e = &events[events_done & events_mask];
+
+    switch (e->type)
+    {
+      case EVT_SHOT:
+        due |= 1u << SND_BULLET;
+        break;
+
+      case EVT_HIT:
+      case EVT_SPLIT:
+        add_score(100 / (e->size + 1));
+
+        due |= 1u << (SND_AST1 + e->size - 1);
+
+        particles_emit(&(Emitter){
+          .x = e->x,
+          .y = e->y,
+          .radius = kAsteroidsRadius * kFixOne,
+          .xm = e->xm,
+          .ym = e->ym,
+          .speed = e->size * 3 * kFixOne / 2,
+          .life = kParticleLife,
+          .count = e->count});
+        break;
+
+      case EVT_DEATH:
+        due |= 1u << SND_EXPLODE;
+
+        --lives;
+
+        if (!lives)
+        {
+          due |= 1u << SND_GAMEOVER;
+          player_die_timer = 100;
+        }
+        break;
+
+      case EVT_EXTRA_LIFE:
+        strcpy(zoom_str, "EXTRA LIFE");
+        text_zoom = kZoomStart;
+        due |= 1u << SND_EXTRALIFE;
+        break;
+    }
+  }
+
+  sounds_due |= due;
+}
+
+/* Break an asteroid and add an explosion ('xm' and 'ym' are the speed
+   of whatever hit it): */
+
+static void
+hurt_asteroid(int32_t j, int32_t xm, int32_t ym, size_t exp_size)
+{
+  int32_t size = asteroids.size[j];
+  int32_t x = asteroids.x[j], y = asteroids.y[j];
+
+  /* Add explosion (and score it, later): */
+
+  events_emit(&(Event){
+    .type = (size > 1 ? EVT_SPLIT : EVT_HIT),
+    .size = size,
+    .x = x,
+    .y = y,
+    .xm = (xm + asteroids.xm[j] * kAsteroidsStep) / 3,
+    .ym = (ym + asteroids.ym[j] * kAsteroidsStep) / 3,
+    .count = exp_size * kExplosionScale});
+
+  if (size > 1)
+  {
+    /* Break the rock into two smaller ones! */
+
+    add_asteroid(x,
+                 y,
+                 ((asteroids.xm[j] + xm / kAsteroidsStep) / 2),
+                 (asteroids.ym[j] + ym / kAsteroidsStep),
+                 size - 1);
+
+    add_asteroid(x,
+                 y,
+                 (asteroids.xm[j] + xm / kAsteroidsStep),
+                 ((asteroids.ym[j] + ym / kAsteroidsStep) / 2),
+                 size - 1);
+  }
+
+  /* Make the original go away: */
+
+  asteroids.alive[j] = 0;
+  pool_free(&asteroid_pool, j);
+  grid_remove(j);
+}
+
+/* Increment score: */
+
+static void
+add_score(int32_t amount)
+{
+  /* See if they deserve a new life: */
+
+  if (score / kOneUpScore < (score + amount) / kOneUpScore)
+  {
+    lives++;
+    events_emit(&(Event){.type = EVT_EXTRA_LIFE});
+  }
+
+  /* Add to score: */
+
+  score = score + amount;
+}
+
+static void
+reset_level(void)
+{
+  for (size_t i = 0; i < max_bullets; i++)
+  {
+    bullets.timer[i] = 0;
+  }
+
+  for (size_t i = 0; i < max_asteroids; i++)
+  {
+    asteroids.alive[i] = 0;
+  }
+
+  pool_clear(&bullet_pool);
+  pool_clear(&asteroid_pool);
+  grid_clear();
+
+  particles.count = 0;
+
+  /* (In stress mode, every level starts with the same huge swarm:) */
+
+  size_t rocks = (level + 1 < 10 ? level + 1 : 10);
+
+  if (stress_rocks)
+  {
+    rocks = stress_rocks;
+  }
+
+  /* (They start near the left and right edges, away from the ship; in a
+     bigger world, anywhere outside the view it starts with:) */
+
+  for (size_t i = 0; i < rocks; i++)
+  {
+    add_asteroid(/* x */ (world_scale > 1 ? (world_w / 2 + screen_w / 2 + random_range(world_w - screen_w)) % world_w
+                                         : (random_range(40) + (world_w - 40) * random_range(2))) * kFixOne,
+                 /* y */ random_range(world_h) * kFixOne,
+                 /* xm */ (random_range(9) - 4) * (kFixOne / kAsteroidsStep),
+                 /* ym */ (random_range(9) - 4) * 4 * (kFixOne / kAsteroidsStep),
+                 /* size */ random_range(3) + 2);
+  }
+
+  sprintf(zoom_str, "LEVEL %ld", level);
+
+  text_zoom = kZoomStart;
+}
+
+/* A batch of 'count' games, game g started from seeds[g] (NULL if there
+   isn't room for them, or in bounce mode, which batches don't play): */
+
+GymBatch*
+gym_batch_new(size_t count, const uint64_t* seeds)
+{
+  GymBatch* batch = calloc(1, sizeof(GymBatch));
+  Arena game = arena;
+
+  if (!batch || !count || bounce_rocks)
+  {
+    free(batch);
+    return NULL;
+  }
+
+  /* (Size and lay out the batch's arena the way arena_setup() does the
+     game's, with the game's put aside meanwhile:) */
+
+  batch->count = count;
+
+  arena = (Arena){0};
+  gym_batch_tables(batch);
+
+  arena.size = arena.used;
+  arena.base = calloc(1, arena.size);
+
+  if (arena.base)
+  {
+    arena.used = 0;
+    gym_batch_tables(batch);
+  }
+
+  batch->arena = arena;
+  arena = game;
+
+  if (!batch->arena.base)
+  {
+    free(batch);
+    return NULL;
+  }
+
+  for (size_t g = 0; g < count; g++)
+  {
+    random_spread(batch->rng[g], seeds[g]);
+    gym_batch_reset(batch, g);
+  }
+
+  return batch;
+}
+
+void
+gym_batch_free(GymBatch* batch)
+{
+  if (!batch)
+  {
+    return;
+  }
+
+  free(batch->arena.base);
+  free(batch);
+}
+
+/* Step every game in 'batch' once, game g with actions[g] held, leaving
+   its reward, whether it ended and (if 'obs' isn't NULL) what it sees
+   next in rewards[g], dones[g] and obs[g].  A game plays out just as it
+   would through gym_step() from the same seed, and one that ends goes
+   straight on to a new one, as if from gym_reset() with its stream as it
+   stands: */
+
+void
+gym_batch_step(GymBatch* batch, const uint32_t* actions, int32_t* rewards, bool* dones, GymObs* obs)
+{
+  GymBatchStep step = {batch, actions, rewards, dones, obs};
+
+  jobs_run(gym_batch_job, &step, batch->count, jobs_chunk(batch->count, kGymGrain));
+}
+
+/* Carve out a batch's tables (or, before its arena exists, add up how big
+   they are): */
+
+static void
+gym_batch_tables(GymBatch* b)
+{
+  const size_t n = b->count;
+
+  b->player_x = arena_alloc(n * sizeof(int32_t));
+  b->player_y = arena_alloc(n * sizeof(int32_t));
+  b->player_xm = arena_alloc(n * sizeof(int32_t));
+  b->player_ym = arena_alloc(n * sizeof(int32_t));
+  b->player_angle = arena_alloc(n * sizeof(int32_t));
+  b->player_alive = arena_alloc(n * sizeof(int32_t));
+  b->player_die_timer = arena_alloc(n * sizeof(int32_t));
+  b->text_zoom = arena_alloc(n * sizeof(int32_t));
+  b->lives = arena_alloc(n * sizeof(size_t));
+  b->score = arena_alloc(n * sizeof(size_t));
+  b->level = arena_alloc(n * sizeof(size_t));
+  b->sim_counter = arena_alloc(n * sizeof(size_t));
+  b->rng = arena_alloc(n * sizeof(*b->rng));
+
+  b->bullet_pool = arena_alloc(n * sizeof(Pool));
+  gym_batch_pools(b->bullet_pool, n, max_bullets);
+  b->asteroid_pool = arena_alloc(n * sizeof(Pool));
+  gym_batch_pools(b->asteroid_pool, n, max_asteroids);
+
+  bullets_alloc(&b->bullets, n * max_bullets);
+  b->bullet_hits = arena_alloc(n * max_bullets * sizeof(int32_t));
+
+  b->asteroids.alive = arena_alloc(n * max_asteroids * sizeof(int32_t));
+  b->asteroids.size = arena_alloc(n * max_asteroids * sizeof(int32_t));
+  b->asteroids.x = arena_alloc(n * max_asteroids * sizeof(int32_t));
+  b->asteroids.y = arena_alloc(n * max_asteroids * sizeof(int32_t));
+  b->asteroids.xm = arena_alloc(n * max_asteroids * sizeof(int32_t));
+  b->asteroids.ym = arena_alloc(n * max_asteroids * sizeof(int32_t));
+}
+
+/* One pool of 'capacity' slots for each of 'n' games, their lists packed
+   side by side: */
+
+static void
+gym_batch_pools(Pool* pools, size_t n, size_t capacity)
+{
+  int32_t* next = arena_alloc(n * capacity * sizeof(int32_t));
+  int32_t* live = arena_alloc(n * capacity * sizeof(int32_t));
+  int32_t* index = arena_alloc(n * capacity * sizeof(int32_t));
+
+  if (!pools)
+  {
+    return;
+  }
+
+  for (size_t g = 0; g < n; g++)
+  {
+    pools[g] = (Pool){.next = next + g * capacity, .live = live + g * capacity, .index = index + g * capacity, .capacity = capacity};
+    pool_clear(&pools[g]);
+  }
+}
+
+/* Step games [begin, end) of a batch, in game_step()'s order: what is the
+   same for every game (moving things, and finding what each bullet hit)
+   runs across the games; the rest, game by game: */
+
+static void
+gym_batch_job(void* data, size_t begin, size_t end)
+{
+  const GymBatchStep* st = data;
+  GymBatch* b = st->batch;
+  const size_t n = b->count, games = end - begin;
+
+  /* Fire, steer, and bring ships back: */
+
+  for (size_t g = begin; g < end; g++)
+  {
+    st->rewards[g] = 0;
+    st->dones[g] = gym_batch_control(b, g, st->actions[g]);
+  }
+
+  /* Move ships and bullets: */
+
+  move_bodies(b->player_x + begin, b->player_y + begin, b->player_xm + begin, b->player_ym + begin, games);
+
+  for (size_t s = 0; s < max_bullets; s++)
+  {
+    size_t at = s * n + begin;
+
+    move_bodies(b->bullets.x + at, b->bullets.y + at, b->bullets.xm + at, b->bullets.ym + at, games);
+  }
+
+  /* Look for every bullet's hit, then apply them: */
+
+  gym_batch_hits(b, begin, end);
+
+  for (size_t g = begin; g < end; g++)
+  {
+    gym_batch_shots(b, g, &st->rewards[g]);
+  }
+
+  /* Move asteroids: */
+
+  for (size_t s = 0; s < max_asteroids; s++)
+  {
+    size_t at = s * n + begin;
+
+    move_bodies(b->asteroids.x + at, b->asteroids.y + at, b->asteroids.xm + at, b->asteroids.ym + at, games);
+  }
+
+  /* Crash ships, clear levels, start games over, and look around: */
+
+  for (size_t g = begin; g < end; g++)
+  {
+    gym_batch_finish(b, g, &st->rewards[g]);
+
+    if (st->dones[g])
+    {
+      gym_batch_reset(b, g);
+    }
+
+    if (st->obs)
+    {
+      gym_batch_observe(b, g, &st->obs[g]);
+    }
+  }
+}
+
+/* Fire, turn and thrust game 'g''s ship, and count down to bringing it
+   back if it is dead.  Returns true once the game is over: */
+
+static bool
+gym_batch_control(GymBatch* b, size_t g, uint32_t actions)
+{
+  bool over = false;
+
+  ++b->sim_counter[g];
+
+  if ((actions & ACTION_FIRE) && b->player_alive[g])
+  {
+    gym_batch_bullet(b, g);
+  }
+
+  if (actions & ACTION_RIGHT)
+  {
+    b->player_angle[g] -= 8;
+    if (b->player_angle[g] < 0)
+    {
+      b->player_angle[g] += 360;
+    }
+  }
+  else if (actions & ACTION_LEFT)
+  {
+    b->player_angle[g] += 8;
+    if (b->player_angle[g] >= 360)
+    {
+      b->player_angle[g] -= 360;
+    }
+  }
+
+  if ((actions & ACTION_THRUST) && b->player_alive[g])
+  {
+    b->player_xm[g] += (trig_cos(trig_deg(b->player_angle[g])) * 3) >> kTrigShift;
+    b->player_ym[g] -= (trig_sin(trig_deg(b->player_angle[g])) * 3) >> kTrigShift;
+  }
+  else if (!(b->sim_counter[g] % 20))
+  {
+    b->player_xm[g] = (b->player_xm[g] * 7) / 8;
+    b->player_ym[g] = (b->player_ym[g] * 7) / 8;
+  }
+
+  if (!b->player_alive[g] && --b->player_die_timer[g] <= 0)
+  {
+    if (b->lives[g] > 0)
+    {
+      b->player_die_timer[g] = 0;
+      b->player_angle[g] = 90;
+      b->player_x[g] = (world_w / 2) << 4;
+      b->player_y[g] = (world_h / 2) << 4;
+      b->player_xm[g] = 0;
+      b->player_ym[g] = 0;
+      b->player_alive[g] = !(!(actions & ACTION_SHIFT) && gym_batch_crowded(b, g));
+    }
+    else
+    {
+      over = true;
+    }
+  }
+
+  return over;
+}
+
+/* Is any of game 'g''s rocks too close to where its ship would come back? */
+
+static bool
+gym_batch_crowded(const GymBatch* b, size_t g)
+{
+  const size_t n = b->count;
+  const int32_t px = b->player_x[g] >> 4, py = b->player_y[g] >> 4;
+
+  for (size_t s = 0; s < b->asteroid_pool[g].used; s++)
+  {
+    int32_t ax = b->asteroids.x[s * n + g] >> kFixShift, ay = b->asteroids.y[s * n + g] >> kFixShift;
+
+    if (b->asteroids.alive[s * n + g] && ax >= px - (screen_w / 5) && ax <= px + (screen_w / 5) && ay >= py - (screen_h / 5) && ay <= py + (screen_h / 5))
+    {
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static void
+gym_batch_bullet(GymBatch* b, size_t g)
+{
+  Pool* pool = &b->bullet_pool[g];
+
+  if (pool->count >= pool->capacity)
+  {
+    return;
+  }
+
+  size_t at = pool_alloc(pool) * b->count + g;
+  int32_t a = trig_deg(b->player_angle[g]);
+
+  b->bullets.timer[at] = 50;
+  b->bullets.x[at] = b->player_x[g];
+  b->bullets.y[at] = b->player_y[g];
+  b->bullets.xm[at] = ((trig_cos(a) * kBulletSpeed * kFixOne) >> kTrigShift) + b->player_xm[g];
+  b->bullets.ym[at] = -((trig_sin(a) * kBulletSpeed * kFixOne) >> kTrigShift) + b->player_ym[g];
+}
+
+/* Wear out the live bullets of games [begin, end), and find the first
+   rock (in slot order) each one swept through, as the rocks stood when
+   the pass began (-1 for none).  Four games at a time where the compiler
+   offers vector types, the rest one by one: */
+
+static void
+gym_batch_hits(GymBatch* b, size_t begin, size_t end)
+{
+  const size_t n = b->count;
+  size_t used = 0;
+
+  for (size_t g = begin; g < end; g++)
+  {
+    used = (b->asteroid_pool[g].used > used ? b->asteroid_pool[g].used : used);
+  }
+
+  for (size_t s = 0; s < max_bullets; s++)
+  {
+    int32_t* timer = b->bullets.timer + s * n;
+    int32_t* hits = b->bullet_hits + s * n;
+    size_t g = begin;
+
+#if defined(__GNUC__)
+    const int32_t w = world_w * kFixOne, h = world_h * kFixOne;
+    const vec4i vw = {w, w, w, w}, vh = {h, h, h, h};
+    const vec4i zero = {0, 0, 0, 0};
+
+    for (; g + 4 <= end; g += 4)
+    {
+      vec4i t, best = {INT32_MAX, INT32_MAX, INT32_MAX, INT32_MAX};
+
+      /* (Live bullets are the ones with time left; comparisons give
+         all-ones lanes where true:) */
+
+      memcpy(&t, timer + g, sizeof(t));
+      t += (t > zero);
+      memcpy(timer + g, &t, sizeof(t));
+
+      const vec4i live = (t > zero);
+
+      if (live[0] | live[1] | live[2] | live[3])
+      {
+        vec4i bx, by, vx, vy;
+
+        memcpy(&bx, b->bullets.x + s * n + g, sizeof(bx));
+        memcpy(&by, b->bullets.y + s * n + g, sizeof(by));
+        memcpy(&vx, b->bullets.xm + s * n + g, sizeof(vx));
+        memcpy(&vy, b->bullets.ym + s * n + g, sizeof(vy));
+
+        /* (How far a bullet came this step, each way:) */
+
+        const vec4i ux = (vx ^ (vx >> 31)) - (vx >> 31), uy = (vy ^ (vy >> 31)) - (vy >> 31);
+
+        for (size_t k = 0; k < used; k++)
+        {
+          vec4i alive, ax, ay, size;
+
+          memcpy(&alive, b->asteroids.alive + k * n + g, sizeof(alive));
+          memcpy(&ax, b->asteroids.x + k * n + g, sizeof(ax));
+          memcpy(&ay, b->asteroids.y + k * n + g, sizeof(ay));
+          memcpy(&size, b->asteroids.size + k * n + g, sizeof(size));
+
+          const vec4i rad = (size * kAsteroidsRadius + kBulletRadius) * kFixOne;
+          const vec4i dx = short_way4(bx - ax, vw), dy = short_way4(by - ay, vh);
+
+          /* (Only a rock within 'rad' of both ends' box can be hit; the
+             exact test, in 64-bit lanes, is for the rare ones that are:) */
+
+          const vec4i near = (dx <= rad + ux) & (dx >= -rad - ux) & (dy <= rad + uy) & (dy >= -rad - uy) & (alive != zero) & live;
+
+          if (!(near[0] | near[1] | near[2] | near[3]))
+          {
+            continue;
+          }
+
+          const vec4i hit = sweep_hits4(dx, dy, vx, vy, rad) & near;
+          const vec4i j = ((int32_t)k | ~hit) & INT32_MAX;
+          const vec4i lower = j < best;
+
+          best = (j & lower) | (best & ~lower);
+        }
+      }
+
+      /* (No hit, INT32_MAX, becomes -1:) */
+
+      best |= (best == INT32_MAX);
+      memcpy(hits + g, &best, sizeof(best));
+    }
+#endif
+
+    for (; g < end; g++)
+    {
+      timer[g] -= (timer[g] > 0);
+      hits[g] = (timer[g] > 0 ? gym_batch_first(b, g, s) : -1);
+    }
+  }
+}
+
+/* The lowest-numbered rock of game 'g' its bullet 'i' swept through, or
+   -1: */
+
+static int32_t
+gym_batch_first(const GymBatch* b, size_t g, size_t i)
+{
+  for (size_t s = 0; s < b->asteroid_pool[g].used; s++)
+  {
+    if (gym_batch_sweeps(b, g, i, s))
+    {
+      return s;
+    }
+  }
+
+  return -1;
+}
+
+/* Did game 'g''s bullet 'i' pass through its live rock 'j' on the way
+   here? */
+
+static bool
+gym_batch_sweeps(const GymBatch* b, size_t g, size_t i, int32_t j)
+{
+  const size_t n = b->count, at = i * n + g, rock = j * n + g;
+  const int32_t w = world_w * kFixOne, h = world_h * kFixOne;
+  int32_t dx = b->bullets.x[at] - b->asteroids.x[rock], dy = b->bullets.y[at] - b->asteroids.y[rock];
+
+  dx -= -(dx > w / 2) & w;
+  dx += -(dx < -w / 2) & w;
+  dy -= -(dy > h / 2) & h;
+  dy += -(dy < -h / 2) & h;
+
+  return (b->asteroids.alive[rock] && sweep_hits(dx, dy, b->bullets.xm[at], b->bullets.ym[at], (b->asteroids.size[rock] * kAsteroidsRadius + kBulletRadius) * kFixOne));
+}
+
+/* Apply game 'g''s bullet hits one by one, as game_step() does: */
+
+static void
+gym_batch_shots(GymBatch* b, size_t g, int32_t* reward)
+{
+  const size_t n = b->count;
+  Pool* pool = &b->bullet_pool[g];
+
+  for (size_t k = pool->count; k-- > 0;)
+  {
+    size_t i = pool->live[k], at = i * n + g;
+    int32_t j = b->bullet_hits[at];
+
+    if (j != -1 && !gym_batch_sweeps(b, g, i, j))
+    {
+      j = gym_batch_first(b, g, i);
+    }
+
+    if (j != -1)
+    {
+      b->bullets.timer[at] = 0;
+      gym_batch_hurt(b, g, j, b->bullets.xm[at], b->bullets.ym[at], reward);
+    }
+
+    if (b->bullets.timer[at] <= 0)
+    {
+      pool_free(pool, i);
+    }
+  }
+}
+
+/* The rest of game 'g''s step, once its rocks have moved: the ship runs
+   into the lowest-numbered rock it touches, if any, then the zoom text
+   shrinks, and the level is over if the bullets left no rocks: */
+
+static void
+gym_batch_finish(GymBatch* b, size_t g, int32_t* reward)
+{
+  const size_t n = b->count;
+  const size_t rocks = b->asteroid_pool[g].count;
+
+  if (b->player_alive[g])
+  {
+    const int32_t px = b->player_x[g] >> 4, py = b->player_y[g] >> 4;
+    int32_t hit = -1;
+
+    for (size_t s = 0; s < b->asteroid_pool[g].used && hit == -1; s++)
+    {
+      int32_t ax = b->asteroids.x[s * n + g] >> kFixShift, ay = b->asteroids.y[s * n + g] >> kFixShift;
+
+      if (b->asteroids.alive[s * n + g] && ax >= px - kShipRadius && ax <= px + kShipRadius && ay >= py - kShipRadius && ay <= py + kShipRadius)
+      {
+        hit = s;
+      }
+    }
+
+    if (hit != -1)
+    {
+      gym_batch_hurt(b, g, hit, b->player_xm[g], b->player_ym[g], reward);
+
+      b->player_alive[g] = 0;
+      b->player_die_timer[g] = 30;
+
+      if (!--b->lives[g])
+      {
+        b->player_die_timer[g] = 100;
+      }
+    }
+  }
+
+  if (b->text_zoom[g] > 0 && !(b->sim_counter[g] % 2))
+  {
+    --b->text_zoom[g];
+  }
+
+  if (!rocks)
+  {
+    ++b->level[g];
+    gym_batch_level(b, g);
+  }
+}
+
+/* add_asteroid(), for game 'g': */
+
+static void
+gym_batch_rock(GymBatch* b, size_t g, int32_t x, int32_t y, int32_t xm, int32_t ym, int32_t size)
+{
+  int32_t found = pool_alloc(&b->asteroid_pool[g]);
+
+  while (xm == 0)
+  {
+    xm = (random_below(b->rng[g], 3) - 1) * (kFixOne / kAsteroidsStep);
+  }
+
+  if (found != -1)
+  {
+    size_t at = found * b->count + g;
+
+    b->asteroids.alive[at] = 1;
+    b->asteroids.x[at] = x;
+    b->asteroids.y[at] = y;
+    b->asteroids.xm[at] = xm;
+    b->asteroids.ym[at] = ym;
+    b->asteroids.size[at] = size;
+
+    /* (Spin and outlines are only drawn, but drawing them keeps the
+       stream in step with the game's:) */
+
+    random_below(b->rng[g], 360);
+    random_below(b->rng[g], 6);
+
+    for (size_t i = 0; i < kAsteroidsSides; i++)
+    {
+      random_below(b->rng[g], 3);
+      random_below(b->rng[g], 40);
+    }
+  }
+}
+
+/* hurt_asteroid(), for game 'g', scoring it there and then: */
+
+static void
+gym_batch_hurt(GymBatch* b, size_t g, int32_t j, int32_t xm, int32_t ym, int32_t* reward)
+{
+  const size_t at = j * b->count + g;
+  const int32_t size = b->asteroids.size[at];
+  const int32_t x = b->asteroids.x[at], y = b->asteroids.y[at];
+
+  gym_batch_score(b, g, 100 / (size + 1), reward);
+
+  if (size > 1)
+  {
+    gym_batch_rock(b,
+                   g,
+                   x,
+                   y,
+                   ((b->asteroids.xm[at] + xm / kAsteroidsStep) / 2),
+                   (b->asteroids.ym[at] + ym / kAsteroidsStep),
+                   size - 1);
+
+    gym_batch_rock(b,
+                   g,
+                   x,
+                   y,
+                   (b->asteroids.xm[at] + xm / kAsteroidsStep),
+                   ((b->asteroids.ym[at] + ym / kAsteroidsStep) / 2),
+                   size - 1);
+  }
+
+  b->asteroids.alive[at] = 0;
+  pool_free(&b->asteroid_pool[g], j);
+}
+
+/* add_score(), for game 'g': */
+
+static void
+gym_batch_score(GymBatch* b, size_t g, int32_t amount, int32_t* reward)
+{
+  if (b->score[g] / kOneUpScore < (b->score[g] + amount) / kOneUpScore)
+  {
+    b->lives[g]++;
+    b->text_zoom[g] = kZoomStart;
+  }
+
+  b->score[g] += amount;
+  *reward += amount;
+}
+
+/* reset_level(), for game 'g': */
+
+static void
+gym_batch_level(GymBatch* b, size_t g)
+{
+  const size_t n = b->count;
+
+  for (size_t s = 0; s < max_bullets; s++)
+  {
+    b->bullets.timer[s * n + g] = 0;
+  }
+
+  for (size_t s = 0; s < max_asteroids; s++)
+  {
+    b->asteroids.alive[s * n + g] = 0;
+  }
+
+  pool_clear(&b->bullet_pool[g]);
+  pool_clear(&b->asteroid_pool[g]);
+
+  size_t rocks = (b->level[g] + 1 < 10 ? b->level[g] + 1 : 10);
+
+  if (stress_rocks)
+  {
+    rocks = stress_rocks;
+  }
+
+  for (size_t i = 0; i < rocks; i++)
+  {
+    gym_batch_rock(b,
+                   g,
+                   /* x */ (world_scale > 1 ? (world_w / 2 + screen_w / 2 + random_below(b->rng[g], world_w - screen_w)) % world_w
+                                            : (random_below(b->rng[g], 40) + (world_w - 40) * random_below(b->rng[g], 2))) * kFixOne,
+                   /* y */ random_below(b->rng[g], world_h) * kFixOne,
+                   /* xm */ (random_below(b->rng[g], 9) - 4) * (kFixOne / kAsteroidsStep),
+                   /* ym */ (random_below(b->rng[g], 9) - 4) * 4 * (kFixOne / kAsteroidsStep),
+                   /* size */ random_below(b->rng[g], 3) + 2);
+  }
+
+  b->text_zoom[g] = kZoomStart;
+}
+
+/* game_reset() (and gym_reset()'s clock), for game 'g': */
+
+static void
+gym_batch_reset(GymBatch* b, size_t g)
+{
+  b->sim_counter[g] = 0;
+  b->lives[g] = 3;
+  b->score[g] = 0;
+
+  b->player_alive[g] = 1;
+  b->player_die_timer[g] = 0;
+  b->player_angle[g] = 90;
+  b->player_x[g] = (world_w / 2) << 4;
+  b->player_y[g] = (world_h / 2) << 4;
+  b->player_xm[g] = 0;
+  b->player_ym[g] = 0;
+
+  b->level[g] = 1;
+  gym_batch_level(b, g);
+}
+
+/* gym_observe(), for game 'g': */
+
+static void
+gym_batch_observe(const GymBatch* b, size_t g, GymObs* obs)
+{
+  const size_t n = b->count;
+  const Pool* rock_pool = &b->asteroid_pool[g];
+  const Pool* shot_pool = &b->bullet_pool[g];
+  int32_t px = b->player_x[g] >> kFixShift, py = b->player_y[g] >> kFixShift;
+  size_t rocks = (rock_pool->count < kGymRocks ? rock_pool->count : kGymRocks);
+  size_t shots = (shot_pool->count < kGymBullets ? shot_pool->count : kGymBullets);
+
+  obs->ship_x = (int16_t)px;
+  obs->ship_y = (int16_t)py;
+  obs->ship_xm = (int16_t)b->player_xm[g];
+  obs->ship_ym = (int16_t)b->player_ym[g];
+  obs->ship_angle = (int16_t)b->player_angle[g];
+  obs->ship_alive = (uint8_t)b->player_alive[g];
+  obs->lives = (uint8_t)(b->lives[g] < 255 ? b->lives[g] : 255);
+  obs->num_rocks = (uint8_t)rocks;
+  obs->num_bullets = (uint8_t)shots;
+
+  for (size_t k = 0; k < rocks; k++)
+  {
+    size_t at = rock_pool->live[k] * n + g;
+
+    obs->rock_dx[k] = gym_delta(px, b->asteroids.x[at] >> kFixShift, world_w);
+    obs->rock_dy[k] = gym_delta(py, b->asteroids.y[at] >> kFixShift, world_h);
+    obs->rock_xm[k] = (int16_t)b->asteroids.xm[at];
+    obs->rock_ym[k] = (int16_t)b->asteroids.ym[at];
+    obs->rock_size[k] = (uint8_t)b->asteroids.size[at];
+  }
+
+  for (size_t k = 0; k < shots; k++)
+  {
+    size_t at = shot_pool->live[k] * n + g;
+
+    obs->bullet_dx[k] = gym_delta(px, b->bullets.x[at] >> kFixShift, world_w);
+    obs->bullet_dy[k] = gym_delta(py, b->bullets.y[at] >> kFixShift, world_h);
+  }
+}
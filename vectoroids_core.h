@@ -0,0 +1,221 @@
+/*
+  vectoroids_core.h
+
+  The Vectoroids simulation: everything that plays the game, and nothing
+  that draws it, sounds it or reads a joystick (no SDL at all), so that
+  headless tools, benchmarks and bots can link the very same code as the
+  game itself.
+
+  Set it up with config_set() or config_load() (optional), random_seed()
+  (optional) and core_init(); start a game with game_reset(); advance it
+  with game_step(); look at it with core_state().  All the game state is
+  global, so there is one game per process (or as many as you like in a
+  gym batch).  The game's own front end reaches further in, through
+  vectoroids_core_internal.h; nothing else should.
+*/
+
+#ifndef VECTOROIDS_CORE_H
+#define VECTOROIDS_CORE_H
+
+#include <stdbool.h>
+#include <stddef.h>
+#include <stdint.h>
+
+/* Constraints: */
+
+#define kNumBullets 2
+#define kNumAsteroids 20
+
+/* Everything that moves does so in 1/16 pixel units: */
+
+#define kFixShift 4
+#define kFixOne (1 << kFixShift)
+
+/* Actions for gym_step(), one bit each: */
+
+#define ACTION_LEFT 0x0001
+#define ACTION_RIGHT 0x0002
+#define ACTION_THRUST 0x0004
+#define ACTION_FIRE 0x0008
+#define ACTION_SHIFT 0x0010
+
+#define kGymRocks kNumAsteroids
+#define kGymBullets kNumBullets
+
+/* Types: */
+
+typedef struct Bullets Bullets;
+struct Bullets
+{
+  int32_t* timer;
+  int32_t* x;
+  int32_t* y;
+  int32_t* xm;
+  int32_t* ym;
+};
+
+/* Asteroids only pick up 1/kAsteroidsStep of the speed of whatever hits
+   them.  Their outlines only change when a rock spawns, so those are kept
+   apart from the rest: */
+
+typedef struct Asteroids Asteroids;
+struct Asteroids
+{
+  int32_t* alive;
+  int32_t* size;
+  int32_t* x;
+  int32_t* y;
+  int32_t* xm;
+  int32_t* ym;
+  int32_t* angle;
+  int32_t* angle_m;
+};
+
+/* Explosion debris, packed so that the first 'count' are the live ones.
+   (Like the other entity tables, the arrays are carved out of the arena
+   at startup, sized by the configured capacities.) */
+
+typedef struct Particles Particles;
+struct Particles
+{
+  size_t count;
+  int32_t* life;
+  int32_t* x;
+  int32_t* y;
+  int32_t* xm;
+  int32_t* ym;
+};
+
+/* Things that happen during a simulation step (shots, broken rocks, the
+   ship's death, extra lives), which the sound, debris, score and zoom text
+   code catch up on together once the step's collisions are done.  Until
+   the next step starts, the step's events stay readable, in order, for
+   anyone else (analytics, replays): see core_state(): */
+
+enum
+{
+  EVT_SHOT,
+  EVT_HIT,
+  EVT_SPLIT,
+  EVT_DEATH,
+  EVT_EXTRA_LIFE
+};
+
+typedef struct Event Event;
+struct Event
+{
+  int32_t type;
+  int32_t size;
+  int32_t x;
+  int32_t y;
+  int32_t xm;
+  int32_t ym;
+  size_t count;
+};
+
+/* Controls held (or pressed) for the next simulation step ('stamp' is
+   only for whoever measures input latency): */
+
+typedef struct Input Input;
+struct Input
+{
+  bool left;
+  bool right;
+  bool up;
+  bool shift;
+  size_t fire;
+  uint32_t stamp;
+};
+
+/* What the game looks like after a step (the tables are the game's own,
+   so only read them, and only until the next step).  The step's events
+   are events[k & events_mask], for k from events_head up to
+   events_tail: */
+
+typedef struct CoreState CoreState;
+struct CoreState
+{
+  int32_t player_x;
+  int32_t player_y;
+  int32_t player_xm;
+  int32_t player_ym;
+  int32_t player_angle;
+  int32_t player_alive;
+  size_t lives;
+  size_t score;
+  size_t level;
+  int32_t world_w;
+  int32_t world_h;
+  const Bullets* bullets;
+  const int32_t* bullets_live;
+  size_t num_bullets;
+  const Asteroids* asteroids;
+  const int32_t* asteroids_live;
+  size_t num_asteroids;
+  const Particles* particles;
+  const Event* events;
+  size_t events_mask;
+  size_t events_head;
+  size_t events_tail;
+};
+
+/* What a bot gets to see after each gym_step(): the ship, and (up to
+   kGymRocks and kGymBullets of) the rocks and bullets, in pixels relative to
+   the ship the short way around the world; speeds are in 1/16 pixels per
+   step: */
+
+typedef struct GymObs GymObs;
+struct GymObs
+{
+  int16_t ship_x;
+  int16_t ship_y;
+  int16_t ship_xm;
+  int16_t ship_ym;
+  int16_t ship_angle;
+  uint8_t ship_alive;
+  uint8_t lives;
+  uint8_t num_rocks;
+  uint8_t num_bullets;
+  int16_t rock_dx[kGymRocks];
+  int16_t rock_dy[kGymRocks];
+  int16_t rock_xm[kGymRocks];
+  int16_t rock_ym[kGymRocks];
+  uint8_t rock_size[kGymRocks];
+  int16_t bullet_dx[kGymBullets];
+  int16_t bullet_dy[kGymBullets];
+};
+
+/* A saved game, for gym_clone() and gym_restore(), and many games played
+   side by side, for gym_batch_step() (what is in them is the core's
+   business): */
+
+typedef struct GymState GymState;
+typedef struct GymBatch GymBatch;
+
+/* The library's interface: */
+
+bool config_load(const char* path, bool required);
+bool config_set(const char* key, const char* value);
+void random_seed(uint64_t seed);
+void core_init(void);
+void core_state(CoreState* st);
+void game_reset(void);
+bool game_step(const Input* input);
+
+/* Reinforcement learning ("gym") interface, on top of the above, for one
+   game (after core_init(); with "particles 0" configured, no time is spent
+   on debris either), or for a batch of them (which plays by the same
+   rules, but not in bounce mode; it is split over whatever jobs_run()
+   runs on): */
+
+void gym_reset(uint64_t seed);
+bool gym_step(uint32_t actions, int32_t* reward);
+void gym_observe(GymObs* obs);
+GymState* gym_state_new(void);
+void gym_clone(GymState* st);
+void gym_restore(const GymState* st);
+GymBatch* gym_batch_new(size_t count, const uint64_t* seeds);
+void gym_batch_free(GymBatch* batch);
+void gym_batch_step(GymBatch* batch, const uint32_t* actions, int32_t* rewards, bool* dones, GymObs* obs);
+
+#endif
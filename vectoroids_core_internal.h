@@ -0,0 +1,205 @@
+/*
+  vectoroids_core_internal.h
+
+  The parts of the Vectoroids simulation that the game's own front end
+  reaches into: the tables it draws from and snapshots, the setup steps
+  and hooks it drives, and the odd helper.  Not installed with the
+  library; tools and bots use vectoroids_core.h alone.
+*/
+
+#ifndef VECTOROIDS_CORE_INTERNAL_H
+#define VECTOROIDS_CORE_INTERNAL_H
+
+#include <stdio.h>
+
+#include "vectoroids_core.h"
+
+/* Constraints: */
+
+#define kStressSplits 8
+#define kMaxWorkers 16
+#define kJobChunks 256
+
+#define kAsteroidsSides 6
+#define kAsteroidsRadius 10
+#define kAsteroidsStep 4
+#define kShipRadius 20
+
+/* Trig tables take binary angles, kTrigSize steps per turn, and return
+   Q1.14 fractions (kTrigOne is 1.0): */
+
+#define kTrigBits 12
+#define kTrigSize (1 << kTrigBits)
+#define kTrigShift 14
+#define kTrigOne (1 << kTrigShift)
+
+#define kZoomStart 40
+
+#define kGridCell 60
+#define kMaxWorld 8
+
+/* Types: */
+
+/* Slot allocator for a table of entities: free slots are chained through
+   'next', and the ones in use are kept packed in 'live' ('index' says
+   where each sits in it, or -1).  Slots below 'used' have been handed
+   out since the last clear: */
+
+typedef struct Pool Pool;
+struct Pool
+{
+  int32_t* next;
+  int32_t* live;
+  int32_t* index;
+  size_t capacity;
+  size_t count;
+  size_t used;
+  int32_t free;
+  size_t dropped;
+};
+
+typedef struct Shape Shape;
+struct Shape
+{
+  int32_t radius;
+  int32_t angle;
+};
+
+/* The one block of memory every table is carved out of at startup (the
+   game state tables come first, and take up 'state' bytes): */
+
+typedef struct Arena Arena;
+struct Arena
+{
+  uint8_t* base;
+  size_t size;
+  size_t used;
+  size_t state;
+};
+
+/* Sounds the simulation can call for (it only says which; see
+   'sounds_due'): */
+
+enum
+{
+  SND_BULLET,
+  SND_AST1,
+  SND_AST2,
+  SND_AST3,
+  SND_AST4,
+  SND_THRUST,
+  SND_EXPLODE,
+  SND_GAMEOVER,
+  SND_EXTRALIFE,
+  NUM_SOUNDS
+};
+
+/* PRNG streams (see random_setup()): */
+
+enum
+{
+  RNG_GAME,
+  RNG_EFFECTS,
+  RNG_DRAW,
+  NUM_RNG
+};
+
+typedef void (*JobFn)(void* data, size_t begin, size_t end);
+
+/* Game state: */
+
+extern Bullets bullets;
+extern Asteroids asteroids;
+extern Shape (*shapes)[kAsteroidsSides];
+extern Pool bullet_pool;
+extern Pool asteroid_pool;
+extern Particles particles;
+extern size_t particles_dropped;
+extern int32_t player_x, player_y, player_xm, player_ym, player_angle;
+extern int32_t player_alive, player_die_timer;
+extern size_t lives, score, level;
+extern int32_t text_zoom;
+extern char zoom_str[24];
+extern size_t sim_counter;
+extern uint64_t rngstate[NUM_RNG][4];
+extern const int16_t sin_table[kTrigSize + kTrigSize / 4];
+
+/* Sounds called for since the caller last cleared it, one bit each: */
+
+extern uint32_t sounds_due;
+
+/* Configuration (see config_set()), and what core_init() made of it: */
+
+extern size_t max_bullets;
+extern size_t max_asteroids;
+extern size_t max_particles;
+extern size_t stress_rocks;
+extern size_t job_workers;
+extern bool bounce_rocks;
+extern Arena arena;
+extern int32_t screen_w;
+extern int32_t screen_h;
+extern size_t world_scale;
+extern int32_t world_w;
+extern int32_t world_h;
+
+/* The asteroid grid (which the drawing culls by), and how bounce mode's
+   sweep and the event ring have fared: */
+
+extern int32_t grid_cols;
+extern int32_t grid_rows;
+extern int32_t* grid_head;
+extern int32_t* grid_next;
+extern size_t sap_tests;
+extern size_t events_dropped;
+
+/* Hooks for whoever links the core: jobs_run() runs the simulation's
+   parallel loops (one after another on the calling thread, unless it is
+   pointed at a thread pool), and tables_extra() (if set) is called at the
+   end of tables_alloc() to carve more tables out of the arena: */
+
+extern void (*jobs_run)(JobFn fn, void* data, size_t n, size_t size);
+extern void (*tables_extra)(void);
+
+/* Moves every moving thing; world_setup() picks the version made for the
+   world's size: */
+
+extern void (*move_bodies)(int32_t* restrict x, int32_t* restrict y, const int32_t* restrict xm, const int32_t* restrict ym, size_t n);
+
+/* Everything else the front end uses: */
+
+void random_setup(void);
+void random_fill(uint64_t s[4], int32_t* out, size_t n, uint32_t bound);
+int32_t random_range(uint32_t bound);
+int32_t random_effect(uint32_t bound);
+int32_t random_fx(uint32_t bound);
+void jobs_serial(JobFn fn, void* data, size_t n, size_t size);
+void* arena_alloc(size_t size);
+void world_setup(void);
+void arena_setup(void);
+void bullets_alloc(Bullets* b, size_t n);
+void asteroids_alloc(Asteroids* a, size_t n);
+void particles_alloc(Particles* p, size_t n);
+void state_tables(FILE* fi, bool save);
+int32_t trig_deg(int32_t deg);
+int32_t trig_sin(int32_t a);
+int32_t trig_cos(int32_t a);
+void trig_sincos(const int32_t* restrict a, int32_t* restrict s, int32_t* restrict c, size_t n);
+void pool_rebuild(Pool* pool, const int32_t* in_use);
+void add_asteroid(int32_t x, int32_t y, int32_t xm, int32_t ym, int32_t size);
+void grid_rebuild(void);
+void rocks_clear(void);
+size_t rocks_bounce(void);
+
+/* Which grid row or column holds a (possibly off-screen) coordinate? */
+
+static inline int32_t
+grid_index(int32_t v, int32_t count)
+{
+  int32_t c = (v >= 0 ? v / kGridCell : -((kGridCell - 1 - v) / kGridCell));
+
+  c = c % count;
+  return (c < 0 ? c + count : c);
+}
+
+#endif